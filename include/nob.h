@@ -93,7 +93,8 @@
       - NOB_FREE(ptr) - Redefine which free() nob.h shall use.
       - NOB_DEPRECATED(message) - Redefine how nob.h shall mark functions as deprecated.
       - NOB_DA_INIT_CAP - Redefine initial capacity of Dynamic Arrays.
-      - NOB_TEMP_CAPACITY - Redefine the capacity of the temporary storate.
+      - NOB_TEMP_CAPACITY - Redefine the size of the blocks the temporary storage grows by.
+      - NOB_THREAD_LOCAL - Redefine how nob.h shall declare the per-thread temporary storage.
       - NOB_REBUILD_URSELF(binary_path, source_path) - redefine how nob.h shall rebuild itself.
       - NOB_WIN32_ERR_MSG_SIZE - Redefine the capacity of the buffer for error message on Windows.
 */
@@ -129,6 +130,16 @@
 #define NOB_FREE free
 #endif /* NOB_FREE */
 
+#ifndef NOB_THREAD_LOCAL
+#    if defined(_MSC_VER)
+#        define NOB_THREAD_LOCAL __declspec(thread)
+#    elif defined(__GNUC__) || defined(__clang__)
+#        define NOB_THREAD_LOCAL __thread
+#    else
+#        define NOB_THREAD_LOCAL _Thread_local
+#    endif
+#endif /* NOB_THREAD_LOCAL */
+
 #ifdef NOB_WARN_DEPRECATED
 #    ifndef NOB_DEPRECATED
 #        if defined(__GNUC__) || defined(__clang__)
@@ -167,12 +178,20 @@
 #else
 #    ifdef __APPLE__
 #        include <mach-o/dyld.h>
+#        include <copyfile.h>
+#    endif
+#    ifdef __linux__
+#        include <sys/ioctl.h>
+#        include <sys/sendfile.h>
+#        include <sys/syscall.h>
+#        include <linux/fs.h>
 #    endif
 #    ifdef __FreeBSD__
 #        include <sys/sysctl.h>
 #    endif
 #    include <sys/types.h>
 #    include <sys/wait.h>
+#    include <signal.h>
 #    include <sys/stat.h>
 #    include <unistd.h>
 #    include <fcntl.h>
@@ -497,6 +516,10 @@ NOBDEF bool nob_procs_wait(Nob_Procs procs);
 // Wait until all the processes have finished and empty the procs array.
 NOBDEF bool nob_procs_flush(Nob_Procs *procs);
 
+// Block until any of the processes has finished, `index` receives its position in procs.
+// Returns 1 if it exited successfully, 0 if it failed and -1 if waiting itself failed.
+NOBDEF int nob_procs_wait_any(Nob_Procs procs, size_t *index);
+
 // Alias to nob_procs_flush
 NOB_DEPRECATED("Use `nob_procs_flush(&procs)` instead.")
 NOBDEF bool nob_procs_wait_and_reset(Nob_Procs *procs);
@@ -708,6 +731,9 @@ NOB_DEPRECATED("Use `nob_cmd_run(&cmd, "
                ".stderr_path = \"path/to/stderr\")` instead.")
 NOBDEF bool nob_cmd_run_sync_redirect_and_reset(Nob_Cmd *cmd, Nob_Cmd_Redirect redirect);
 
+// The temporary storage is a stack of linked blocks of NOB_TEMP_CAPACITY bytes (bigger allocations get
+// a block of their own), so it grows instead of running out. Every thread has its own, threads other
+// than the main one should call nob_temp_free() before they exit.
 #ifndef NOB_TEMP_CAPACITY
 #define NOB_TEMP_CAPACITY (8*1024*1024)
 #endif // NOB_TEMP_CAPACITY
@@ -740,6 +766,10 @@ NOBDEF char *nob_temp_vsprintf(const char *format, va_list ap);
 NOBDEF void nob_temp_reset(void);
 NOBDEF size_t nob_temp_save(void);
 NOBDEF void nob_temp_rewind(size_t checkpoint);
+// Releases the blocks of the calling thread, everything allocated by it becomes invalid.
+NOBDEF void nob_temp_free(void);
+// The highest nob_temp_save() of the calling thread so far, in bytes.
+NOBDEF size_t nob_temp_high_water(void);
 
 // Given any path returns the last part of that path.
 // "/path/to/a/file.c" -> "file.c"; "/path/to/a/directory" -> "directory"
@@ -914,11 +944,6 @@ NOBDEF char *nob_win32_error_message(DWORD err);
 
 #ifdef NOB_IMPLEMENTATION
 
-// This is like nob_proc_wait() but waits asynchronously. Depending on the platform ms means different thing.
-// On Windows it means timeout. On POSIX it means for how long to sleep after checking if the process exited,
-// so to not peg the core too much. Since this API is kinda of weird, the function is private for now.
-static int nob__proc_wait_async(Nob_Proc proc, int ms);
-
 // Starts the process for the command. Its main purpose is to be the base for nob_cmd_run() and nob_cmd_run_opt().
 static Nob_Proc nob__cmd_start_process(Nob_Cmd cmd, Nob_Fd *fdin, Nob_Fd *fdout, Nob_Fd *fderr);
 
@@ -1030,8 +1055,20 @@ NOBDEF void nob__go_rebuild_urself(int argc, char **argv, const char *source_pat
     exit(0);
 }
 
-static size_t nob_temp_size = 0;
-static char nob_temp[NOB_TEMP_CAPACITY] = {0};
+typedef struct Nob_Temp_Block {
+    struct Nob_Temp_Block *prev;
+    struct Nob_Temp_Block *next;    // Kept after a rewind for reuse
+    size_t base;                    // Checkpoint of data[0], the sum of capacities of all previous blocks
+    size_t capacity;
+    size_t size;
+} Nob_Temp_Block;
+
+typedef struct {
+    Nob_Temp_Block *current;
+    size_t high_water;
+} Nob_Temp_Arena;
+
+static NOB_THREAD_LOCAL Nob_Temp_Arena nob_temp_arena = {0};
 
 NOBDEF bool nob_mkdir_if_not_exists(const char *path)
 {
@@ -1093,6 +1130,35 @@ NOBDEF bool nob_copy_file(const char *src_path, const char *dst_path)
         nob_log(NOB_ERROR, "Could not create file %s: %s", dst_path, strerror(errno));
         nob_return_defer(false);
     }
+    // open() applies umask, existing files keep their old mode
+    fchmod(dst_fd, src_stat.st_mode & 07777);
+
+    // Cheapest first. Each step continues from the file offsets where the previous one gave up,
+    // the read/write loop below finishes whatever is left.
+#if defined(__linux__)
+#   ifdef FICLONE
+    // Reflink on copy-on-write filesystems (btrfs, xfs, bcachefs), no data is copied
+    if (ioctl(dst_fd, FICLONE, src_fd) == 0) nob_return_defer(true);
+#   endif // FICLONE
+#   ifdef SYS_copy_file_range
+    // In-kernel copy inside one filesystem, server side on NFS and SMB.
+    // Through syscall(), glibc only declares it with _GNU_SOURCE
+    for (;;) {
+        ssize_t n = syscall(SYS_copy_file_range, src_fd, NULL, dst_fd, NULL, (size_t)1 << 30, 0);
+        if (n == 0) nob_return_defer(true);
+        if (n < 0) break;
+    }
+#   endif // SYS_copy_file_range
+    // In-kernel copy across filesystems
+    for (;;) {
+        ssize_t n = sendfile(dst_fd, src_fd, NULL, (size_t)1 << 30);
+        if (n == 0) nob_return_defer(true);
+        if (n < 0) break;
+    }
+#elif defined(__APPLE__)
+    // Copies without going through our buffer
+    if (fcopyfile(src_fd, dst_fd, NULL, COPYFILE_DATA) == 0) nob_return_defer(true);
+#endif
 
     for (;;) {
         ssize_t n = read(src_fd, buf, buf_size);
@@ -1206,14 +1272,11 @@ NOBDEF bool nob_cmd_run_opt(Nob_Cmd *cmd, Nob_Cmd_Opt opt)
 
     if (opt.async && max_procs > 0) {
         while (opt.async->count >= max_procs) {
-            for (size_t i = 0; i < opt.async->count; ++i) {
-                int ret = nob__proc_wait_async(opt.async->items[i], 1);
-                if (ret < 0) nob_return_defer(false);
-                if (ret) {
-                    nob_da_remove_unordered(opt.async, i);
-                    break;
-                }
-            }
+            size_t index = 0;
+            int ret = nob_procs_wait_any(*opt.async, &index);
+            if (ret < 0) nob_return_defer(false);
+            nob_da_remove_unordered(opt.async, index);
+            if (ret == 0) nob_return_defer(false);
         }
     }
 
@@ -1332,14 +1395,11 @@ NOBDEF bool nob_chain_end_opt(Nob_Chain *chain, Nob_Chain_End_Opt opt)
 
         if (opt.async && max_procs > 0) {
             while (opt.async->count >= max_procs) {
-                for (size_t i = 0; i < opt.async->count; ++i) {
-                    int ret = nob__proc_wait_async(opt.async->items[i], 1);
-                    if (ret < 0) nob_return_defer(false);
-                    if (ret) {
-                        nob_da_remove_unordered(opt.async, i);
-                        break;
-                    }
-                }
+                size_t index = 0;
+                int ret = nob_procs_wait_any(*opt.async, &index);
+                if (ret < 0) nob_return_defer(false);
+                nob_da_remove_unordered(opt.async, index);
+                if (ret == 0) nob_return_defer(false);
             }
         }
 
@@ -1660,6 +1720,126 @@ NOBDEF bool nob_procs_flush(Nob_Procs *procs)
     return success;
 }
 
+NOBDEF int nob_procs_wait_any(Nob_Procs procs, size_t *index)
+{
+    if (procs.count == 0) {
+        nob_log(NOB_ERROR, "could not wait on any process: no processes given");
+        return -1;
+    }
+
+#ifdef _WIN32
+    // WaitForMultipleObjects() takes at most MAXIMUM_WAIT_OBJECTS handles, bigger sets are polled in chunks
+    bool chunked = procs.count > MAXIMUM_WAIT_OBJECTS;
+    for (size_t offset = 0;; offset += MAXIMUM_WAIT_OBJECTS) {
+        if (offset >= procs.count) offset = 0;
+        size_t n = procs.count - offset;
+        if (n > MAXIMUM_WAIT_OBJECTS) n = MAXIMUM_WAIT_OBJECTS;
+        DWORD result = WaitForMultipleObjects((DWORD)n, procs.items + offset, FALSE, chunked ? 1 : INFINITE);
+        if (result == WAIT_TIMEOUT) continue;
+        if (result == WAIT_FAILED || result >= WAIT_OBJECT_0 + n) {
+            nob_log(NOB_ERROR, "could not wait on child processes: %s", nob_win32_error_message(GetLastError()));
+            return -1;
+        }
+        *index = offset + (result - WAIT_OBJECT_0);
+        break;
+    }
+
+    Nob_Proc proc = procs.items[*index];
+    DWORD exit_status;
+    if (!GetExitCodeProcess(proc, &exit_status)) {
+        nob_log(NOB_ERROR, "could not get process exit code: %s", nob_win32_error_message(GetLastError()));
+        CloseHandle(proc);
+        return 0;
+    }
+    CloseHandle(proc);
+    if (exit_status != 0) {
+        nob_log(NOB_ERROR, "command exited with exit code %lu", exit_status);
+        return 0;
+    }
+    return 1;
+#else
+    for (;;) {
+        // Sleep until any child exits, WNOWAIT leaves it for the owner to reap
+        siginfo_t info = {0};
+        if (waitid(P_ALL, 0, &info, WEXITED | WNOWAIT) < 0) {
+            if (errno == EINTR) continue;
+            nob_log(NOB_ERROR, "could not wait on child processes: %s", strerror(errno));
+            return -1;
+        }
+
+        bool ours = false;
+        for (size_t i = 0; i < procs.count; ++i) {
+            if (procs.items[i] == info.si_pid) {
+                *index = i;
+                ours = true;
+                break;
+            }
+        }
+
+        if (!ours) {
+            // Exited child was started by someone else and is not reaped yet, so waitid() would
+            // keep returning it. Check ours, then sleep until the next child exits. SIGCHLD stays
+            // pending while blocked, so an exit right after the check still wakes us up.
+            sigset_t chld, old_mask;
+            sigemptyset(&chld);
+            sigaddset(&chld, SIGCHLD);
+            sigprocmask(SIG_BLOCK, &chld, &old_mask);
+            int ret = -1;
+            for (size_t i = 0; i < procs.count && ret < 0; ++i) {
+                int wstatus = 0;
+                pid_t pid = waitpid(procs.items[i], &wstatus, WNOHANG);
+                if (pid < 0) {
+                    nob_log(NOB_ERROR, "could not wait on command (pid %d): %s", procs.items[i], strerror(errno));
+                    *index = i;
+                    ret = 0;
+                    break;
+                }
+                if (pid == 0 || !(WIFEXITED(wstatus) || WIFSIGNALED(wstatus))) continue;
+                *index = i;
+                ret = 1;
+                if (WIFSIGNALED(wstatus)) {
+                    nob_log(NOB_ERROR, "command process was terminated by signal %d", WTERMSIG(wstatus));
+                    ret = 0;
+                }
+                else if (WEXITSTATUS(wstatus) != 0) {
+                    nob_log(NOB_ERROR, "command exited with exit code %d", WEXITSTATUS(wstatus));
+                    ret = 0;
+                }
+            }
+            if (ret < 0) {
+#ifdef __linux__
+                // Timeout only matters when another thread took the SIGCHLD
+                struct timespec timeout = { .tv_sec = 1, .tv_nsec = 0 };
+                sigtimedwait(&chld, NULL, &timeout);
+#else
+                // TODO: no sigtimedwait() on macOS, sigwait() could miss a SIGCHLD taken by another thread
+                struct timespec duration = { .tv_sec = 0, .tv_nsec = 10*1000*1000 };
+                nanosleep(&duration, NULL);
+#endif
+            }
+            sigprocmask(SIG_SETMASK, &old_mask, NULL);
+            if (ret >= 0) return ret;
+            continue;
+        }
+
+        int wstatus = 0;
+        if (waitpid(info.si_pid, &wstatus, 0) < 0) {
+            nob_log(NOB_ERROR, "could not wait on command (pid %d): %s", info.si_pid, strerror(errno));
+            return 0;
+        }
+        if (WIFSIGNALED(wstatus)) {
+            nob_log(NOB_ERROR, "command process was terminated by signal %d", WTERMSIG(wstatus));
+            return 0;
+        }
+        if (WEXITSTATUS(wstatus) != 0) {
+            nob_log(NOB_ERROR, "command exited with exit code %d", WEXITSTATUS(wstatus));
+            return 0;
+        }
+        return 1;
+    }
+#endif
+}
+
 NOBDEF bool nob_procs_wait_and_reset(Nob_Procs *procs)
 {
     return nob_procs_flush(procs);
@@ -1722,78 +1902,6 @@ NOBDEF bool nob_proc_wait(Nob_Proc proc)
 #endif
 }
 
-static int nob__proc_wait_async(Nob_Proc proc, int ms)
-{
-    if (proc == NOB_INVALID_PROC) return false;
-
-#ifdef _WIN32
-    DWORD result = WaitForSingleObject(
-                       proc,    // HANDLE hHandle,
-                       ms       // DWORD  dwMilliseconds
-                   );
-
-    if (result == WAIT_TIMEOUT) {
-        return 0;
-    }
-
-    if (result == WAIT_FAILED) {
-        nob_log(NOB_ERROR, "could not wait on child process: %s", nob_win32_error_message(GetLastError()));
-        return -1;
-    }
-
-    DWORD exit_status;
-    if (!GetExitCodeProcess(proc, &exit_status)) {
-        nob_log(NOB_ERROR, "could not get process exit code: %s", nob_win32_error_message(GetLastError()));
-        return -1;
-    }
-
-    if (exit_status != 0) {
-        nob_log(NOB_ERROR, "command exited with exit code %lu", exit_status);
-        return -1;
-    }
-
-    CloseHandle(proc);
-
-    return 1;
-#else
-    long ns = ms*1000*1000;
-    struct timespec duration = {
-        .tv_sec = ns/(1000*1000*1000),
-        .tv_nsec = ns%(1000*1000*1000),
-    };
-
-    int wstatus = 0;
-    pid_t pid = waitpid(proc, &wstatus, WNOHANG);
-    if (pid < 0) {
-        nob_log(NOB_ERROR, "could not wait on command (pid %d): %s", proc, strerror(errno));
-        return -1;
-    }
-
-    if (pid == 0) {
-        nanosleep(&duration, NULL);
-        return 0;
-    }
-
-    if (WIFEXITED(wstatus)) {
-        int exit_status = WEXITSTATUS(wstatus);
-        if (exit_status != 0) {
-            nob_log(NOB_ERROR, "command exited with exit code %d", exit_status);
-            return -1;
-        }
-
-        return 1;
-    }
-
-    if (WIFSIGNALED(wstatus)) {
-        nob_log(NOB_ERROR, "command process was terminated by signal %d", WTERMSIG(wstatus));
-        return -1;
-    }
-
-    nanosleep(&duration, NULL);
-    return 0;
-#endif
-}
-
 NOBDEF bool nob_procs_append_with_flush(Nob_Procs *procs, Nob_Proc proc, size_t max_procs_count)
 {
     nob_da_append(procs, proc);
@@ -2268,9 +2376,34 @@ NOBDEF void *nob_temp_alloc(size_t requested_size)
 {
     size_t word_size = sizeof(uintptr_t);
     size_t size = (requested_size + word_size - 1)/word_size*word_size;
-    if (nob_temp_size + size > NOB_TEMP_CAPACITY) return NULL;
-    void *result = &nob_temp[nob_temp_size];
-    nob_temp_size += size;
+    Nob_Temp_Block *block = nob_temp_arena.current;
+    if (block == NULL || block->size + size > block->capacity) {
+        // Rest of the current block is skipped, checkpoints keep pointing to one place
+        Nob_Temp_Block *next = block != NULL ? block->next : NULL;
+        if (next != NULL && next->capacity < size) {
+            while (next != NULL) {
+                Nob_Temp_Block *after = next->next;
+                NOB_FREE(next);
+                next = after;
+            }
+        }
+        if (next == NULL) {
+            size_t capacity = size > NOB_TEMP_CAPACITY ? size : NOB_TEMP_CAPACITY;
+            next = (Nob_Temp_Block*)NOB_REALLOC(NULL, sizeof(Nob_Temp_Block) + capacity);
+            NOB_ASSERT(next != NULL && "Buy more RAM lol");
+            next->prev = block;
+            next->next = NULL;
+            next->base = block != NULL ? block->base + block->capacity : 0;
+            next->capacity = capacity;
+            if (block != NULL) block->next = next;
+        }
+        next->size = 0;
+        block = next;
+        nob_temp_arena.current = block;
+    }
+    void *result = (char*)(block + 1) + block->size;
+    block->size += size;
+    if (block->base + block->size > nob_temp_arena.high_water) nob_temp_arena.high_water = block->base + block->size;
     return result;
 }
 
@@ -2284,7 +2417,6 @@ NOBDEF char *nob_temp_vsprintf(const char *format, va_list ap)
     NOB_ASSERT(n >= 0);
     char *result = (char*)nob_temp_alloc(n + 1);
     NOB_ASSERT(result != NULL && "Extend the size of the temporary allocator");
-    // TODO: use proper arenas for the temporary allocator;
     va_copy(args, ap);
     vsnprintf(result, n + 1, format, args);
     va_end(args);
@@ -2303,17 +2435,40 @@ NOBDEF char *nob_temp_sprintf(const char *format, ...)
 
 NOBDEF void nob_temp_reset(void)
 {
-    nob_temp_size = 0;
+    nob_temp_rewind(0);
 }
 
 NOBDEF size_t nob_temp_save(void)
 {
-    return nob_temp_size;
+    Nob_Temp_Block *block = nob_temp_arena.current;
+    return block != NULL ? block->base + block->size : 0;
 }
 
 NOBDEF void nob_temp_rewind(size_t checkpoint)
 {
-    nob_temp_size = checkpoint;
+    Nob_Temp_Block *block = nob_temp_arena.current;
+    while (block != NULL && block->prev != NULL && checkpoint < block->base) block = block->prev;
+    if (block == NULL) return;
+    NOB_ASSERT(checkpoint >= block->base && checkpoint - block->base <= block->capacity);
+    block->size = checkpoint - block->base;
+    nob_temp_arena.current = block;
+}
+
+NOBDEF void nob_temp_free(void)
+{
+    Nob_Temp_Block *block = nob_temp_arena.current;
+    while (block != NULL && block->prev != NULL) block = block->prev;
+    while (block != NULL) {
+        Nob_Temp_Block *next = block->next;
+        NOB_FREE(block);
+        block = next;
+    }
+    nob_temp_arena.current = NULL;
+}
+
+NOBDEF size_t nob_temp_high_water(void)
+{
+    return nob_temp_arena.high_water;
 }
 
 NOBDEF const char *nob_temp_sv_to_cstr(Nob_String_View sv)
@@ -2854,6 +3009,7 @@ NOBDEF char *nob_temp_running_executable_path(void)
         #define procs_wait_and_reset nob_procs_wait_and_reset
         #define procs_append_with_flush nob_procs_append_with_flush
         #define procs_flush nob_procs_flush
+        #define procs_wait_any nob_procs_wait_any
         #define Cmd Nob_Cmd
         #define Cmd_Redirect Nob_Cmd_Redirect
         #define Cmd_Opt Nob_Cmd_Opt
@@ -0,0 +1,990 @@
+#ifndef NOB_ARCHIVE_H
+#define NOB_ARCHIVE_H
+
+#ifdef NOB_IMPLEMENTATION
+    #undef NOB_IMPLEMENTATION
+    #include "nob.h"
+    #define NOB_IMPLEMENTATION
+#else
+    #include "nob.h"
+#endif
+#include "nob_utils.h"
+
+// Archive extraction without tar, unzip or a shell - DEFLATE decoder (RFC 1951) streaming into
+// tar (ustar, GNU long names, pax paths) and zip readers. `strip_lvl` works like tar's --strip-components.
+
+#define INFLATE_FAST_BITS 10
+#define INFLATE_WINDOW (32*1024)
+// Decoded bytes are handed to the sink in chunks of this size
+#define INFLATE_CHUNK (256*1024)
+#define INFLATE_INPUT_CHUNK (64*1024)
+
+static uint32_t archive__crc_table[256] = {0};
+
+static void archive__crc_init(void) {
+	if (archive__crc_table[1] != 0) return;
+	for (uint32_t i = 0; i < 256; ++i) {
+		uint32_t crc = i;
+		for (int bit = 0; bit < 8; ++bit) crc = crc & 1 ? 0xedb88320u ^ (crc >> 1) : crc >> 1;
+		archive__crc_table[i] = crc;
+	}
+}
+
+// CRC-32 of gzip and zip, start with 0 and feed the result back to chain data
+static uint32_t archive__crc(uint32_t crc, const unsigned char *bytes, size_t count) {
+	crc = ~crc;
+	for (size_t i = 0; i < count; ++i) crc = archive__crc_table[(crc ^ bytes[i]) & 0xff] ^ (crc >> 8);
+	return ~crc;
+}
+
+// Canonical Huffman code. Codes up to INFLATE_FAST_BITS long decode with one lookup,
+// longer ones bit by bit through count/symbol.
+struct InflateHuffman {
+	uint16_t fast[1 << INFLATE_FAST_BITS];   // symbol << 4 | length, 0 for longer codes
+	uint16_t count[16];                      // Number of codes of each length
+	uint16_t symbol[288];                    // Symbols ordered by code
+};
+
+// Decoded bytes, false stops inflating
+typedef bool (*InflateSink)(void *data, const unsigned char *bytes, size_t count);
+
+struct Inflate {
+	FILE *file;                  // Input read in chunks, NULL when all of it is in `in`
+	const unsigned char *in;
+	size_t in_count;
+	size_t in_pos;
+	unsigned char *in_buffer;
+	uint64_t bits;
+	unsigned bit_count;
+	size_t padding;              // Zero bytes added past the end of input
+	unsigned char *out;          // Last INFLATE_WINDOW bytes, then bytes not handed to the sink yet
+	size_t out_count;
+	size_t out_flushed;
+	uint64_t total;
+	uint32_t crc;
+	InflateSink sink;
+	void *sink_data;
+	bool failed;
+};
+
+static void inflate__init(struct Inflate *z, FILE *file, const unsigned char *in, size_t in_count, InflateSink sink, void *sink_data) {
+	memset(z, 0, sizeof(*z));
+	z->file = file;
+	z->in = in;
+	z->in_count = in_count;
+	if (file != NULL) {
+		z->in_buffer = (unsigned char*)malloc(INFLATE_INPUT_CHUNK);
+		NOB_ASSERT(z->in_buffer != NULL && "Buy more RAM lol");
+		z->in = z->in_buffer;
+	}
+	z->out = (unsigned char*)malloc(INFLATE_WINDOW + INFLATE_CHUNK);
+	NOB_ASSERT(z->out != NULL && "Buy more RAM lol");
+	z->sink = sink;
+	z->sink_data = sink_data;
+}
+
+static void inflate__free(struct Inflate *z) {
+	free(z->in_buffer);
+	free(z->out);
+}
+
+static void inflate__refill(struct Inflate *z) {
+	while (z->bit_count <= 56) {
+		if (z->in_pos == z->in_count && z->file != NULL) {
+			z->in_count = fread(z->in_buffer, 1, INFLATE_INPUT_CHUNK, z->file);
+			z->in_pos = 0;
+		}
+		uint64_t byte = 0;
+		if (z->in_pos < z->in_count) byte = z->in[z->in_pos++];
+		// Truncated input decodes as zeros until something notices
+		else if (++z->padding > 16) z->failed = true;
+		z->bits |= byte << z->bit_count;
+		z->bit_count += 8;
+	}
+}
+
+static uint32_t inflate__bits(struct Inflate *z, unsigned count) {
+	if (count == 0) return 0;
+	if (z->bit_count < count) inflate__refill(z);
+	uint32_t value = (uint32_t)(z->bits & ((1ull << count) - 1));
+	z->bits >>= count;
+	z->bit_count -= count;
+	return value;
+}
+
+// Whole input bytes consumed
+static void inflate__align(struct Inflate *z) {
+	inflate__bits(z, z->bit_count % 8);
+}
+
+static bool inflate__flush(struct Inflate *z) {
+	size_t count = z->out_count - z->out_flushed;
+	z->crc = archive__crc(z->crc, z->out + z->out_flushed, count);
+	z->total += count;
+	if (count > 0 && !z->sink(z->sink_data, z->out + z->out_flushed, count)) return false;
+	// Back references reach INFLATE_WINDOW bytes back
+	if (z->out_count > INFLATE_WINDOW) {
+		memmove(z->out, z->out + z->out_count - INFLATE_WINDOW, INFLATE_WINDOW);
+		z->out_count = INFLATE_WINDOW;
+	}
+	z->out_flushed = z->out_count;
+	return true;
+}
+
+// Room for `count` more bytes in the output
+static bool inflate__reserve(struct Inflate *z, size_t count) {
+	if (z->out_count + count <= INFLATE_WINDOW + INFLATE_CHUNK) return true;
+	return inflate__flush(z);
+}
+
+static bool inflate__build(struct InflateHuffman *h, const uint8_t *lengths, size_t count) {
+	uint16_t offsets[16];
+	uint32_t next_code[16];
+	memset(h, 0, sizeof(*h));
+	for (size_t i = 0; i < count; ++i) h->count[lengths[i]] += 1;
+	h->count[0] = 0;
+
+	// Over-subscribed set can't be a prefix code, incomplete is allowed (single distance code)
+	int left = 1;
+	for (int len = 1; len < 16; ++len) {
+		left <<= 1;
+		left -= h->count[len];
+		if (left < 0) return false;
+	}
+
+	offsets[1] = 0;
+	next_code[1] = 0;
+	for (int len = 1; len < 15; ++len) {
+		offsets[len + 1] = offsets[len] + h->count[len];
+		next_code[len + 1] = (next_code[len] + h->count[len]) << 1;
+	}
+	for (size_t i = 0; i < count; ++i) {
+		uint8_t len = lengths[i];
+		if (len == 0) continue;
+		h->symbol[offsets[len]++] = (uint16_t)i;
+		uint32_t code = next_code[len]++;
+		if (len > INFLATE_FAST_BITS) continue;
+		// Stream holds codes most significant bit first
+		uint32_t reversed = 0;
+		for (int bit = 0; bit < len; ++bit) reversed |= ((code >> bit) & 1) << (len - 1 - bit);
+		for (uint32_t k = reversed; k < (1u << INFLATE_FAST_BITS); k += 1u << len) {
+			h->fast[k] = (uint16_t)(i << 4 | len);
+		}
+	}
+	return true;
+}
+
+// Symbol or -1 for a code not in the set
+static int inflate__decode(struct Inflate *z, const struct InflateHuffman *h) {
+	if (z->bit_count < 15) inflate__refill(z);
+	uint16_t entry = h->fast[z->bits & ((1u << INFLATE_FAST_BITS) - 1)];
+	if (entry != 0) {
+		z->bits >>= entry & 15;
+		z->bit_count -= entry & 15;
+		return entry >> 4;
+	}
+	int code = 0;
+	int first = 0;
+	int index = 0;
+	for (int len = 1; len < 16; ++len) {
+		code |= (int)inflate__bits(z, 1);
+		int count = h->count[len];
+		if (code - count < first) return h->symbol[index + (code - first)];
+		index += count;
+		first += count;
+		first <<= 1;
+		code <<= 1;
+	}
+	return -1;
+}
+
+static const uint16_t inflate__length_base[29] = {3,4,5,6,7,8,9,10,11,13,15,17,19,23,27,31,35,43,51,59,67,83,99,115,131,163,195,227,258};
+static const uint8_t inflate__length_extra[29] = {0,0,0,0,0,0,0,0,1,1,1,1,2,2,2,2,3,3,3,3,4,4,4,4,5,5,5,5,0};
+static const uint16_t inflate__distance_base[30] = {1,2,3,4,5,7,9,13,17,25,33,49,65,97,129,193,257,385,513,769,1025,1537,2049,3073,4097,6145,8193,12289,16385,24577};
+static const uint8_t inflate__distance_extra[30] = {0,0,0,0,1,1,2,2,3,3,4,4,5,5,6,6,7,7,8,8,9,9,10,10,11,11,12,12,13,13};
+
+static bool inflate__codes(struct Inflate *z, const struct InflateHuffman *literals, const struct InflateHuffman *distances) {
+	for (;;) {
+		if (z->failed) return false;
+		int symbol = inflate__decode(z, literals);
+		if (symbol < 0) return false;
+		if (symbol < 256) {
+			if (!inflate__reserve(z, 1)) return false;
+			z->out[z->out_count++] = (unsigned char)symbol;
+			continue;
+		}
+		if (symbol == 256) return true;
+
+		symbol -= 257;
+		if (symbol >= 29) return false;
+		size_t length = inflate__length_base[symbol] + inflate__bits(z, inflate__length_extra[symbol]);
+		symbol = inflate__decode(z, distances);
+		if (symbol < 0 || symbol >= 30) return false;
+		size_t distance = inflate__distance_base[symbol] + inflate__bits(z, inflate__distance_extra[symbol]);
+		if (!inflate__reserve(z, length)) return false;
+		if (distance > z->out_count) return false;
+		// Overlapping copy repeats the last `distance` bytes
+		unsigned char *to = z->out + z->out_count;
+		const unsigned char *from = to - distance;
+		for (size_t i = 0; i < length; ++i) to[i] = from[i];
+		z->out_count += length;
+	}
+}
+
+static bool inflate__stored(struct Inflate *z) {
+	inflate__align(z);
+	uint32_t length = inflate__bits(z, 16);
+	uint32_t complement = inflate__bits(z, 16);
+	if ((length ^ 0xffff) != complement) return false;
+	for (uint32_t i = 0; i < length; ++i) {
+		if (!inflate__reserve(z, 1)) return false;
+		z->out[z->out_count++] = (unsigned char)inflate__bits(z, 8);
+	}
+	return !z->failed;
+}
+
+static bool inflate__fixed(struct Inflate *z, struct InflateHuffman *literals, struct InflateHuffman *distances) {
+	uint8_t lengths[288];
+	size_t i = 0;
+	for (; i < 144; ++i) lengths[i] = 8;
+	for (; i < 256; ++i) lengths[i] = 9;
+	for (; i < 280; ++i) lengths[i] = 7;
+	for (; i < 288; ++i) lengths[i] = 8;
+	inflate__build(literals, lengths, 288);
+	for (i = 0; i < 30; ++i) lengths[i] = 5;
+	inflate__build(distances, lengths, 30);
+	return inflate__codes(z, literals, distances);
+}
+
+static bool inflate__dynamic(struct Inflate *z, struct InflateHuffman *literals, struct InflateHuffman *distances) {
+	static const uint8_t order[19] = {16,17,18,0,8,7,9,6,10,5,11,4,12,3,13,2,14,1,15};
+	uint8_t lengths[288 + 32] = {0};
+	size_t literal_count = inflate__bits(z, 5) + 257;
+	size_t distance_count = inflate__bits(z, 5) + 1;
+	size_t code_count = inflate__bits(z, 4) + 4;
+	if (literal_count > 286 || distance_count > 30) return false;
+
+	for (size_t i = 0; i < code_count; ++i) lengths[order[i]] = (uint8_t)inflate__bits(z, 3);
+	// Code length code, reuses `literals`
+	if (!inflate__build(literals, lengths, 19)) return false;
+
+	memset(lengths, 0, sizeof(lengths));
+	for (size_t i = 0; i < literal_count + distance_count;) {
+		int symbol = inflate__decode(z, literals);
+		if (symbol < 0) return false;
+		if (symbol < 16) {
+			lengths[i++] = (uint8_t)symbol;
+			continue;
+		}
+		uint8_t value = 0;
+		size_t repeat;
+		if (symbol == 16) {
+			if (i == 0) return false;
+			value = lengths[i - 1];
+			repeat = 3 + inflate__bits(z, 2);
+		}
+		else if (symbol == 17) repeat = 3 + inflate__bits(z, 3);
+		else repeat = 11 + inflate__bits(z, 7);
+		if (i + repeat > literal_count + distance_count) return false;
+		while (repeat-- > 0) lengths[i++] = value;
+	}
+	if (lengths[256] == 0) return false;
+	if (!inflate__build(literals, lengths, literal_count)) return false;
+	if (!inflate__build(distances, lengths + literal_count, distance_count)) return false;
+	return inflate__codes(z, literals, distances);
+}
+
+// Decode one DEFLATE stream, whatever the sink didn't get yet is flushed
+static bool inflate_run(struct Inflate *z) {
+	struct InflateHuffman *tables = (struct InflateHuffman*)malloc(2 * sizeof(struct InflateHuffman));
+	NOB_ASSERT(tables != NULL && "Buy more RAM lol");
+	bool ok = true;
+	bool last = false;
+	while (ok && !last) {
+		last = inflate__bits(z, 1);
+		switch (inflate__bits(z, 2)) {
+		case 0: ok = inflate__stored(z); break;
+		case 1: ok = inflate__fixed(z, &tables[0], &tables[1]); break;
+		case 2: ok = inflate__dynamic(z, &tables[0], &tables[1]); break;
+		default: ok = false;
+		}
+	}
+	free(tables);
+	return ok && !z->failed && inflate__flush(z);
+}
+
+//--------------Tar-------------------------------------------------------------
+enum TAR_STATE {
+	TAR_HEADER,
+	TAR_FILE,
+	TAR_SKIP,
+	TAR_LONG_NAME,
+	TAR_LONG_LINK,
+	TAR_PAX,
+	TAR_END,
+};
+
+struct TarReader {
+	const char *target_dir;
+	unsigned int strip_lvl;
+	enum TAR_STATE state;
+	unsigned char header[512];
+	size_t header_count;
+	uint64_t data_left;
+	uint64_t padding_left;
+	FILE *file;
+	Nob_String_Builder path;          // Output path of current entry
+	Nob_String_Builder long_name;     // GNU 'L' or pax path for the next entry
+	Nob_String_Builder long_link;
+	Nob_String_Builder data;          // Long name or pax records being read
+	unsigned int mode;
+	uint64_t mtime;
+	size_t entries;
+	bool failed;
+};
+
+// `path` without the first `strip_lvl` components, joined to `target_dir`. False for entries to skip,
+// `unsafe` for ones escaping target_dir.
+static bool archive__output_path(const char *target_dir, unsigned int strip_lvl, const char *path, size_t length, Nob_String_Builder *out, bool *unsafe) {
+	*unsafe = false;
+	out->count = 0;
+	nob_sb_append_cstr(out, target_dir);
+	if (out->count > 0 && out->items[out->count - 1] != '/') nob_da_append(out, '/');
+	size_t root = out->count;
+	if (length > 0 && (path[0] == '/' || path[0] == '\\')) *unsafe = true;
+
+	unsigned int component = 0;
+	for (size_t i = 0; i < length;) {
+		size_t end = i;
+		while (end < length && path[end] != '/' && path[end] != '\\') end += 1;
+		size_t size = end - i;
+		const char *name = path + i;
+		i = end + 1;
+		if (size == 0 || (size == 1 && name[0] == '.')) continue;
+		if (component++ < strip_lvl) continue;
+		if (size == 2 && name[0] == '.' && name[1] == '.') *unsafe = true;
+		if (memchr(name, ':', size) != NULL) *unsafe = true;
+		if (out->count > root) nob_da_append(out, '/');
+		nob_sb_append_buf(out, name, size);
+	}
+	nob_sb_append_null(out);
+	return out->count - 1 > root && !*unsafe;
+}
+
+// True when a directory of `path` below `target_dir` is a symlink. Writing through one an archive
+// created earlier would land wherever it points.
+static bool archive__through_symlink(const char *target_dir, const char *path) {
+#if !defined(_WIN32)
+	size_t root = strlen(target_dir);
+	char *prefix = strdup(path);
+	NOB_ASSERT(prefix != NULL && "Buy more RAM lol");
+	bool found = false;
+	for (size_t i = root + 1; prefix[i] != '\0' && !found; ++i) {
+		if (prefix[i] != '/') continue;
+		prefix[i] = '\0';
+		struct stat statbuf = {0};
+		found = lstat(prefix, &statbuf) == 0 && S_ISLNK(statbuf.st_mode);
+		prefix[i] = '/';
+	}
+	free(prefix);
+	return found;
+#else
+	NOB_UNUSED(target_dir);
+	NOB_UNUSED(path);
+	return false;
+#endif
+}
+
+#if !defined(_WIN32)
+// Follow `link` from `dir` (relative to target_dir, without trailing slash) the way the kernel would,
+// through symlinks extracted earlier. False when it leaves target_dir or loops.
+static bool archive__link_inside(const char *target_dir, Nob_String_Builder *dir, const char *link, size_t *links_left) {
+	if (link[0] == '/' || link[0] == '\\' || strchr(link, ':') != NULL) return false;
+	for (const char *it = link; *it != '\0';) {
+		size_t size = strcspn(it, "/\\");
+		const char *name = it;
+		it += size;
+		if (*it != '\0') it += 1;
+		if (size == 0 || (size == 1 && name[0] == '.')) continue;
+		if (size == 2 && name[0] == '.' && name[1] == '.') {
+			if (dir->count == 0) return false;
+			while (dir->count > 0 && dir->items[dir->count - 1] != '/') dir->count -= 1;
+			if (dir->count > 0) dir->count -= 1;
+			continue;
+		}
+		size_t parent = dir->count;
+		if (dir->count > 0) nob_da_append(dir, '/');
+		nob_sb_append_buf(dir, name, size);
+
+		// Not there yet or a real file or directory, stays as written
+		const char *path = nob_temp_sprintf("%s/%.*s", target_dir, (int)dir->count, dir->items);
+		struct stat statbuf;
+		if (lstat(path, &statbuf) != 0 || !S_ISLNK(statbuf.st_mode)) continue;
+		char target[4096];
+		ssize_t length = readlink(path, target, sizeof(target) - 1);
+		if (length < 0 || *links_left == 0) return false;
+		*links_left -= 1;
+		target[length] = '\0';
+		dir->count = parent;
+		if (!archive__link_inside(target_dir, dir, target, links_left)) return false;
+	}
+	return true;
+}
+#endif
+
+static uint64_t tar__number(const unsigned char *field, size_t size) {
+	uint64_t value = 0;
+	// GNU base-256 for big values
+	if (field[0] & 0x80) {
+		value = field[0] & 0x7f;
+		for (size_t i = 1; i < size; ++i) value = value << 8 | field[i];
+		return value;
+	}
+	for (size_t i = 0; i < size && field[i] != '\0' && field[i] != ' '; ++i) {
+		if (field[i] < '0' || field[i] > '7') break;
+		value = value << 3 | (uint64_t)(field[i] - '0');
+	}
+	return value;
+}
+
+// Pax records `<length> key=value\n`, only paths matter
+static void tar__parse_pax(struct TarReader *tar) {
+	size_t i = 0;
+	while (i < tar->data.count) {
+		size_t record = 0;
+		size_t start = i;
+		while (i < tar->data.count && isdigit((unsigned char)tar->data.items[i])) record = record * 10 + (size_t)(tar->data.items[i++] - '0');
+		if (record == 0 || start + record > tar->data.count) return;
+		const char *key = tar->data.items + i + 1;
+		const char *value = memchr(key, '=', tar->data.items + start + record - key);
+		if (value == NULL) return;
+		value += 1;
+		size_t value_length = (size_t)(tar->data.items + start + record - 1 - value);
+		size_t key_length = (size_t)(value - 1 - key);
+		Nob_String_Builder *target = NULL;
+		if (key_length == 4 && memcmp(key, "path", 4) == 0) target = &tar->long_name;
+		if (key_length == 8 && memcmp(key, "linkpath", 8) == 0) target = &tar->long_link;
+		if (target != NULL) {
+			target->count = 0;
+			nob_sb_append_buf(target, value, value_length);
+		}
+		i = start + record;
+	}
+}
+
+static void tar__finish_entry(struct TarReader *tar) {
+	if (tar->state == TAR_FILE && tar->file != NULL) {
+		if (fclose(tar->file) != 0) tar->failed = true;
+		tar->file = NULL;
+#if !defined(_WIN32)
+		chmod(tar->path.items, tar->mode & 0777);
+#endif
+		file__set_mtime(tar->path.items, tar->mtime * 1000000000ULL);
+	}
+	else if (tar->state == TAR_LONG_NAME || tar->state == TAR_LONG_LINK) {
+		Nob_String_Builder *target = tar->state == TAR_LONG_NAME ? &tar->long_name : &tar->long_link;
+		target->count = 0;
+		// Data is NUL terminated
+		size_t length = strnlen(tar->data.items, tar->data.count);
+		nob_sb_append_buf(target, tar->data.items, length);
+	}
+	else if (tar->state == TAR_PAX) {
+		tar__parse_pax(tar);
+	}
+	tar->state = TAR_HEADER;
+}
+
+static void tar__header(struct TarReader *tar) {
+	const unsigned char *h = tar->header;
+	bool empty = true;
+	for (size_t i = 0; i < 512 && empty; ++i) empty = h[i] == 0;
+	if (empty) {
+		tar->state = TAR_END;
+		return;
+	}
+
+	// Checksum counts its own field as spaces
+	uint64_t sum = 0;
+	for (size_t i = 0; i < 512; ++i) sum += i >= 148 && i < 156 ? ' ' : h[i];
+	if (sum != tar__number(h + 148, 8)) {
+		nob_log(NOB_ERROR, "Corrupted tar header after %zu entries", tar->entries);
+		tar->failed = true;
+		return;
+	}
+
+	char type = (char)h[156];
+	uint64_t size = tar__number(h + 124, 12);
+	tar->data_left = size;
+	tar->padding_left = (512 - size % 512) % 512;
+	tar->data.count = 0;
+	switch (type) {
+	case 'L': tar->state = TAR_LONG_NAME; return;
+	case 'K': tar->state = TAR_LONG_LINK; return;
+	case 'x': tar->state = TAR_PAX; return;
+	default: break;
+	}
+
+	// Name is prefix/name in ustar, long name or pax path replace both
+	Nob_String_Builder name = {0};
+	if (tar->long_name.count > 0) {
+		nob_sb_append_buf(&name, tar->long_name.items, tar->long_name.count);
+	}
+	else {
+		if (memcmp(h + 257, "ustar", 5) == 0 && h[345] != '\0') {
+			nob_sb_append_buf(&name, (const char*)h + 345, strnlen((const char*)h + 345, 155));
+			nob_da_append(&name, '/');
+		}
+		nob_sb_append_buf(&name, (const char*)h, strnlen((const char*)h, 100));
+	}
+	Nob_String_Builder link_name = {0};
+	if (tar->long_link.count > 0) nob_sb_append_buf(&link_name, tar->long_link.items, tar->long_link.count);
+	else nob_sb_append_buf(&link_name, (const char*)h + 157, strnlen((const char*)h + 157, 100));
+	nob_sb_append_null(&link_name);
+	tar->long_name.count = 0;
+	tar->long_link.count = 0;
+	tar->mode = (unsigned int)tar__number(h + 100, 8);
+	tar->mtime = tar__number(h + 136, 12);
+	tar->entries += 1;
+	tar->state = TAR_SKIP;
+	// Global pax headers, devices, fifos
+	if (strchr("01257", type) == NULL) goto defer;
+
+	bool unsafe = false;
+	if (!archive__output_path(tar->target_dir, tar->strip_lvl, name.items, name.count, &tar->path, &unsafe)) {
+		if (unsafe) {
+			nob_log(NOB_ERROR, "Refusing to extract %.*s outside of %s", (int)name.count, name.items, tar->target_dir);
+			tar->failed = true;
+		}
+		goto defer;
+	}
+
+	if (archive__through_symlink(tar->target_dir, tar->path.items)) {
+		nob_log(NOB_ERROR, "Refusing to extract %s through a symlink", tar->path.items);
+		tar->failed = true;
+		goto defer;
+	}
+
+	if (type == '5') {
+		nob_sb_append_cstr(&tar->path, "/");
+		if (mkdir_parents(tar->path.items) == FAILED) tar->failed = true;
+		goto defer;
+	}
+	if (mkdir_parents(tar->path.items) == FAILED) {
+		tar->failed = true;
+		goto defer;
+	}
+#if !defined(_WIN32)
+	// Replaced without following it, a symlink left at this path would redirect the write
+	struct stat existing;
+	if (lstat(tar->path.items, &existing) == 0 && !S_ISDIR(existing.st_mode) && unlink(tar->path.items) != 0) {
+		nob_log(NOB_ERROR, "Could not replace %s: %s", tar->path.items, strerror(errno));
+		tar->failed = true;
+		goto defer;
+	}
+#else
+	if (nob_file_exists(tar->path.items) == 1) remove(tar->path.items);
+#endif
+	if (type == '0' || type == '\0' || type == '7') {
+#if !defined(_WIN32)
+		int fd = open(tar->path.items, O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, 0644);
+		tar->file = fd < 0 ? NULL : fdopen(fd, "wb");
+		if (fd >= 0 && tar->file == NULL) close(fd);
+#else
+		tar->file = fopen(tar->path.items, "wb");
+#endif
+		if (tar->file == NULL) {
+			nob_log(NOB_ERROR, "Could not create %s: %s", tar->path.items, strerror(errno));
+			tar->failed = true;
+			goto defer;
+		}
+		tar->state = TAR_FILE;
+	}
+#if !defined(_WIN32)
+	else if (type == '2') {
+		// Resolved from the directory of the entry, leading components are already stripped
+		const char *relative = tar->path.items + strlen(tar->target_dir);
+		while (*relative == '/') relative += 1;
+		Nob_String_Builder dir = {0};
+		const char *slash = strrchr(relative, '/');
+		if (slash != NULL) nob_sb_append_buf(&dir, relative, (size_t)(slash - relative));
+		size_t links_left = 40;
+		size_t temp_checkpoint = nob_temp_save();
+		bool inside = archive__link_inside(tar->target_dir, &dir, link_name.items, &links_left);
+		nob_temp_rewind(temp_checkpoint);
+		nob_sb_free(dir);
+		if (!inside) {
+			nob_log(NOB_ERROR, "Refusing symlink %s -> %s pointing outside of %s", tar->path.items, link_name.items, tar->target_dir);
+			tar->failed = true;
+		}
+		else if (symlink(link_name.items, tar->path.items) != 0) {
+			nob_log(NOB_ERROR, "Could not create symlink %s: %s", tar->path.items, strerror(errno));
+			tar->failed = true;
+		}
+	}
+	else if (type == '1') {
+		// Hardlink target is a path inside the archive too
+		Nob_String_Builder target = {0};
+		if (!archive__output_path(tar->target_dir, tar->strip_lvl, link_name.items, strlen(link_name.items), &target, &unsafe) ||
+			archive__through_symlink(tar->target_dir, target.items) ||
+			link(target.items, tar->path.items) != 0) {
+			nob_log(NOB_ERROR, "Could not create hardlink %s", tar->path.items);
+			tar->failed = true;
+		}
+		nob_sb_free(target);
+	}
+#else
+	// TODO: symlinks and hardlinks on Windows
+#endif
+
+defer:
+	nob_sb_free(name);
+	nob_sb_free(link_name);
+}
+
+static bool tar__consume(void *data, const unsigned char *bytes, size_t count) {
+	struct TarReader *tar = (struct TarReader*)data;
+	while (count > 0 && !tar->failed) {
+		if (tar->state == TAR_END) return true;
+		if (tar->state == TAR_HEADER) {
+			size_t n = 512 - tar->header_count;
+			if (n > count) n = count;
+			memcpy(tar->header + tar->header_count, bytes, n);
+			tar->header_count += n;
+			bytes += n;
+			count -= n;
+			if (tar->header_count < 512) break;
+			tar->header_count = 0;
+			tar__header(tar);
+			if (tar->state != TAR_END && tar->data_left == 0 && tar->padding_left == 0) tar__finish_entry(tar);
+			continue;
+		}
+
+		if (tar->data_left > 0) {
+			size_t n = tar->data_left < count ? (size_t)tar->data_left : count;
+			if (tar->state == TAR_FILE && fwrite(bytes, 1, n, tar->file) != n) {
+				nob_log(NOB_ERROR, "Could not write %s: %s", tar->path.items, strerror(errno));
+				tar->failed = true;
+			}
+			else if (tar->state == TAR_LONG_NAME || tar->state == TAR_LONG_LINK || tar->state == TAR_PAX) {
+				nob_sb_append_buf(&tar->data, bytes, n);
+			}
+			tar->data_left -= n;
+			bytes += n;
+			count -= n;
+		}
+		else {
+			size_t n = tar->padding_left < count ? (size_t)tar->padding_left : count;
+			tar->padding_left -= n;
+			bytes += n;
+			count -= n;
+		}
+		if (tar->data_left == 0 && tar->padding_left == 0) tar__finish_entry(tar);
+	}
+	return !tar->failed;
+}
+
+static void tar__free(struct TarReader *tar) {
+	if (tar->file != NULL) fclose(tar->file);
+	nob_sb_free(tar->path);
+	nob_sb_free(tar->long_name);
+	nob_sb_free(tar->long_link);
+	nob_sb_free(tar->data);
+}
+
+// Extract .tar, .tar.gz or .tgz into target_dir in one streaming pass
+enum RESULT extract_tar_archive(const char *archive_path, const char *target_dir, unsigned int strip_lvl) {
+	enum RESULT result = SUCCESS;
+	struct TarReader tar = {0};
+	struct Inflate z = {0};
+	tar.target_dir = target_dir;
+	tar.strip_lvl = strip_lvl;
+	archive__crc_init();
+	FILE *file = fopen(archive_path, "rb");
+	if (file == NULL) {
+		nob_log(NOB_ERROR, "Could not open %s: %s", archive_path, strerror(errno));
+		nob_return_defer(FAILED);
+	}
+	if (!nob_mkdir_if_not_exists(target_dir)) nob_return_defer(FAILED);
+	inflate__init(&z, file, NULL, 0, tar__consume, &tar);
+
+	// gzip member header (RFC 1952), plain tar goes straight to the reader
+	unsigned char magic[2] = {0};
+	size_t magic_count = fread(magic, 1, sizeof(magic), file);
+	rewind(file);
+	if (magic_count < 2 || magic[0] != 0x1f || magic[1] != 0x8b) {
+		size_t count = 0;
+		while ((count = fread(z.in_buffer, 1, INFLATE_INPUT_CHUNK, file)) > 0) {
+			if (!tar__consume(&tar, z.in_buffer, count)) nob_return_defer(FAILED);
+		}
+	}
+	else {
+		inflate__bits(&z, 16);
+		uint32_t method = inflate__bits(&z, 8);
+		uint32_t flags = inflate__bits(&z, 8);
+		// Time, extra flags and OS
+		for (int i = 0; i < 6; ++i) inflate__bits(&z, 8);
+		if (method != 8) {
+			nob_log(NOB_ERROR, "%s: unsupported gzip compression method %u", archive_path, method);
+			nob_return_defer(FAILED);
+		}
+		if (flags & 4) {
+			uint32_t extra = inflate__bits(&z, 16);
+			while (extra-- > 0) inflate__bits(&z, 8);
+		}
+		if (flags & 8) while (inflate__bits(&z, 8) != 0 && !z.failed) {}
+		if (flags & 16) while (inflate__bits(&z, 8) != 0 && !z.failed) {}
+		if (flags & 2) inflate__bits(&z, 16);
+
+		if (!inflate_run(&z)) {
+			if (!tar.failed) nob_log(NOB_ERROR, "%s: corrupted or truncated gzip data", archive_path);
+			nob_return_defer(FAILED);
+		}
+		inflate__align(&z);
+		uint32_t crc = inflate__bits(&z, 16);
+		crc |= inflate__bits(&z, 16) << 16;
+		uint32_t size = inflate__bits(&z, 16);
+		size |= inflate__bits(&z, 16) << 16;
+		if (z.failed || crc != z.crc || size != (uint32_t)z.total) {
+			nob_log(NOB_ERROR, "%s: gzip checksum mismatch", archive_path);
+			nob_return_defer(FAILED);
+		}
+	}
+	if (tar.failed) nob_return_defer(FAILED);
+	if (tar.state != TAR_END && tar.state != TAR_HEADER) {
+		nob_log(NOB_ERROR, "%s: truncated tar archive", archive_path);
+		nob_return_defer(FAILED);
+	}
+
+defer:
+	if (result == FAILED) nob_log(NOB_ERROR, "Failed to extract: %s -> %s", archive_path, target_dir);
+	inflate__free(&z);
+	tar__free(&tar);
+	if (file != NULL) fclose(file);
+	return result;
+}
+
+//--------------Zip-------------------------------------------------------------
+struct ZipEntry {
+	const char *path;            // Output path, malloc'd, NULL for skipped entries
+	const unsigned char *data;   // Compressed data inside the archive
+	uint32_t method;
+	uint32_t compressed_size;
+	uint32_t size;
+	uint32_t crc;
+	uint32_t mode;               // Unix permissions, 0 when the archive has none
+};
+
+struct ZipEntries {
+	struct ZipEntry *items;
+	size_t count;
+	size_t capacity;
+};
+
+struct ZipQueue {
+#if !defined(_WIN32)
+	pthread_mutex_t lock;
+#endif
+	struct ZipEntries *entries;
+	size_t next;
+	bool failed;
+};
+
+static uint32_t zip__u16(const unsigned char *bytes) {
+	return (uint32_t)bytes[0] | (uint32_t)bytes[1] << 8;
+}
+
+static uint32_t zip__u32(const unsigned char *bytes) {
+	return zip__u16(bytes) | zip__u16(bytes + 2) << 16;
+}
+
+struct ZipWrite {
+	FILE *file;
+	const char *path;
+};
+
+static bool zip__write(void *data, const unsigned char *bytes, size_t count) {
+	struct ZipWrite *out = (struct ZipWrite*)data;
+	if (fwrite(bytes, 1, count, out->file) == count) return true;
+	nob_log(NOB_ERROR, "Could not write %s: %s", out->path, strerror(errno));
+	return false;
+}
+
+static bool zip__extract_entry(struct ZipEntry *entry) {
+	struct ZipWrite out = {fopen(entry->path, "wb"), entry->path};
+	if (out.file == NULL) {
+		nob_log(NOB_ERROR, "Could not create %s: %s", entry->path, strerror(errno));
+		return false;
+	}
+	bool ok = true;
+	uint32_t crc = 0;
+	if (entry->method == 0) {
+		ok = entry->compressed_size == entry->size && zip__write(&out, entry->data, entry->size);
+		crc = archive__crc(0, entry->data, entry->size);
+	}
+	else {
+		struct Inflate z = {0};
+		inflate__init(&z, NULL, entry->data, entry->compressed_size, zip__write, &out);
+		ok = inflate_run(&z) && z.total == entry->size;
+		crc = z.crc;
+		inflate__free(&z);
+	}
+	if (fclose(out.file) != 0) ok = false;
+	if (ok && crc != entry->crc) {
+		nob_log(NOB_ERROR, "Checksum mismatch of %s", entry->path);
+		ok = false;
+	}
+	else if (!ok) {
+		nob_log(NOB_ERROR, "Corrupted zip data of %s", entry->path);
+	}
+#if !defined(_WIN32)
+	if (ok && entry->mode != 0) chmod(entry->path, entry->mode & 0777);
+#endif
+	return ok;
+}
+
+static void *zip__worker(void *arg) {
+	struct ZipQueue *queue = (struct ZipQueue*)arg;
+	for (;;) {
+#if !defined(_WIN32)
+		pthread_mutex_lock(&queue->lock);
+#endif
+		size_t index = queue->next++;
+		bool stop = queue->failed || index >= queue->entries->count;
+#if !defined(_WIN32)
+		pthread_mutex_unlock(&queue->lock);
+#endif
+		if (stop) break;
+		struct ZipEntry *entry = &queue->entries->items[index];
+		if (entry->path == NULL || zip__extract_entry(entry)) continue;
+#if !defined(_WIN32)
+		pthread_mutex_lock(&queue->lock);
+#endif
+		queue->failed = true;
+#if !defined(_WIN32)
+		pthread_mutex_unlock(&queue->lock);
+#endif
+	}
+	return NULL;
+}
+
+// Extract .zip into target_dir, entries are decompressed on several threads
+enum RESULT extract_zip_archive(const char *archive_path, const char *target_dir, unsigned int strip_lvl) {
+	enum RESULT result = SUCCESS;
+	Nob_String_Builder archive = {0};
+	struct ZipEntries entries = {0};
+	Nob_String_Builder path = {0};
+	archive__crc_init();
+	if (!nob_read_entire_file(archive_path, &archive)) nob_return_defer(FAILED);
+	if (!nob_mkdir_if_not_exists(target_dir)) nob_return_defer(FAILED);
+	const unsigned char *bytes = (const unsigned char*)archive.items;
+	size_t size = archive.count;
+
+	// End of central directory record, followed by a comment of up to 64 KiB
+	size_t end = SIZE_MAX;
+	for (size_t i = size >= 22 ? size - 22 : SIZE_MAX; i != SIZE_MAX && size - i <= 22 + 0xffff; --i) {
+		if (zip__u32(bytes + i) == 0x06054b50) {
+			end = i;
+			break;
+		}
+	}
+	if (end == SIZE_MAX) {
+		nob_log(NOB_ERROR, "%s is not a zip archive", archive_path);
+		nob_return_defer(FAILED);
+	}
+	size_t count = zip__u16(bytes + end + 10);
+	size_t directory = zip__u32(bytes + end + 16);
+	if (count == 0xffff || directory == 0xffffffff) {
+		// TODO: zip64 archives over 4 GiB
+		nob_log(NOB_ERROR, "%s: zip64 archives are not supported", archive_path);
+		nob_return_defer(FAILED);
+	}
+
+	for (size_t i = 0, at = directory; i < count; ++i) {
+		if (at + 46 > size || zip__u32(bytes + at) != 0x02014b50) {
+			nob_log(NOB_ERROR, "%s: corrupted central directory", archive_path);
+			nob_return_defer(FAILED);
+		}
+		const unsigned char *record = bytes + at;
+		uint32_t name_length = zip__u16(record + 28);
+		const char *name = (const char*)record + 46;
+		size_t local = zip__u32(record + 42);
+		at += 46 + name_length + zip__u16(record + 30) + zip__u16(record + 32);
+		// Name is only readable when the record fits
+		if (at > size) {
+			nob_log(NOB_ERROR, "%s: corrupted central directory", archive_path);
+			nob_return_defer(FAILED);
+		}
+		if (local + 30 > size || zip__u32(bytes + local) != 0x04034b50) {
+			nob_log(NOB_ERROR, "%s: corrupted entry %.*s", archive_path, (int)name_length, name);
+			nob_return_defer(FAILED);
+		}
+
+		struct ZipEntry entry = {0};
+		entry.method = zip__u16(record + 10);
+		entry.crc = zip__u32(record + 16);
+		entry.compressed_size = zip__u32(record + 20);
+		entry.size = zip__u32(record + 24);
+		// Made on Unix keeps permissions in the upper half of external attributes
+		if (record[5] == 3) entry.mode = zip__u32(record + 38) >> 16;
+		size_t data = local + 30 + zip__u16(bytes + local + 26) + zip__u16(bytes + local + 28);
+		if (data + entry.compressed_size > size) {
+			nob_log(NOB_ERROR, "%s: truncated entry %.*s", archive_path, (int)name_length, name);
+			nob_return_defer(FAILED);
+		}
+		entry.data = bytes + data;
+		if (zip__u16(record + 8) & 1) {
+			nob_log(NOB_ERROR, "%s: encrypted entry %.*s", archive_path, (int)name_length, name);
+			nob_return_defer(FAILED);
+		}
+		if (entry.method != 0 && entry.method != 8) {
+			nob_log(NOB_ERROR, "%s: unsupported compression method %u of %.*s", archive_path, entry.method, (int)name_length, name);
+			nob_return_defer(FAILED);
+		}
+
+		bool unsafe = false;
+		bool directory_entry = name_length > 0 && (name[name_length - 1] == '/' || name[name_length - 1] == '\\');
+		if (archive__output_path(target_dir, strip_lvl, name, name_length, &path, &unsafe)) {
+			// Directories up front, threads only write files
+			if (directory_entry) nob_sb_append_cstr(&path, "/");
+			if (mkdir_parents(path.items) == FAILED) nob_return_defer(FAILED);
+			if (!directory_entry) entry.path = strdup(path.items);
+		}
+		else if (unsafe) {
+			nob_log(NOB_ERROR, "Refusing to extract %.*s outside of %s", (int)name_length, name, target_dir);
+			nob_return_defer(FAILED);
+		}
+		nob_da_append(&entries, entry);
+	}
+
+	struct ZipQueue queue = {0};
+	queue.entries = &entries;
+#if !defined(_WIN32)
+	pthread_mutex_init(&queue.lock, NULL);
+	pthread_t threads[16];
+	size_t thread_count = (size_t)nob_nprocs();
+	if (thread_count > NOB_ARRAY_LEN(threads)) thread_count = NOB_ARRAY_LEN(threads);
+	if (thread_count > entries.count) thread_count = entries.count;
+	size_t started = 0;
+	for (size_t i = 1; i < thread_count; ++i) {
+		if (pthread_create(&threads[started], NULL, zip__worker, &queue) != 0) break;
+		started += 1;
+	}
+	zip__worker(&queue);
+	for (size_t i = 0; i < started; ++i) pthread_join(threads[i], NULL);
+	pthread_mutex_destroy(&queue.lock);
+#else
+	// TODO: threads on Windows
+	zip__worker(&queue);
+#endif
+	if (queue.failed) nob_return_defer(FAILED);
+
+defer:
+	if (result == FAILED) nob_log(NOB_ERROR, "Failed to extract: %s -> %s", archive_path, target_dir);
+	for (size_t i = 0; i < entries.count; ++i) free((void*)entries.items[i].path);
+	nob_da_free(entries);
+	nob_sb_free(path);
+	nob_sb_free(archive);
+	return result;
+}
+
+#endif // NOB_ARCHIVE_H
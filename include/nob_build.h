@@ -0,0 +1,1279 @@
+#ifndef NOB_BUILD_H
+#define NOB_BUILD_H
+
+#ifdef NOB_IMPLEMENTATION
+    #undef NOB_IMPLEMENTATION
+    #include "nob.h"
+    #define NOB_IMPLEMENTATION
+#else
+    #include "nob.h"
+#endif
+#include "nob_utils.h"
+#include "nob_graph.h"
+
+#if defined(_WIN32)
+#	include <sys/utime.h>
+#	define utime _utime
+#	define utimbuf _utimbuf
+#else
+#	include <utime.h>
+#endif
+
+// Project level build steps on top of the build graph - turning source directories into jobs
+
+// Build database - fingerprint of the exact command every artifact was last built with.
+// Artifact rebuilds when its own command changes, other artifacts are not touched.
+// Stored as text lines `<16 hex digits> <path>`.
+struct BuildDatabaseEntry {
+	const char *path;            // NULL for empty slot
+	uint64_t fingerprint;
+};
+
+struct BuildDatabase {
+	struct BuildDatabaseEntry *slots; // Open addressing, capacity is power of two
+	size_t count;
+	size_t capacity;
+	bool loaded;
+	struct FileStat file;        // Database file as last read or written, zero when there was none
+};
+
+static struct BuildDatabase build_db = {0};
+
+static struct BuildDatabaseEntry *build_db__find(const char *path) {
+	size_t mask = build_db.capacity - 1;
+	size_t i = (size_t)hash_cstr(HASH_SEED, path) & mask;
+	while (build_db.slots[i].path != NULL && strcmp(build_db.slots[i].path, path) != 0) {
+		i = (i + 1) & mask;
+	}
+	return &build_db.slots[i];
+}
+
+void build_db_set(const char *path, uint64_t fingerprint) {
+	if (build_db.count * 2 >= build_db.capacity) {
+		struct BuildDatabase old = build_db;
+		build_db.capacity = old.capacity == 0 ? 256 : old.capacity * 2;
+		build_db.slots = (struct BuildDatabaseEntry*)calloc(build_db.capacity, sizeof(*build_db.slots));
+		NOB_ASSERT(build_db.slots != NULL && "Buy more RAM lol");
+		for (size_t i = 0; i < old.capacity; ++i) {
+			if (old.slots[i].path != NULL) *build_db__find(old.slots[i].path) = old.slots[i];
+		}
+		free(old.slots);
+	}
+	struct BuildDatabaseEntry *entry = build_db__find(path);
+	if (entry->path == NULL) {
+		entry->path = strdup(path);
+		NOB_ASSERT(entry->path != NULL && "Buy more RAM lol");
+		build_db.count += 1;
+	}
+	entry->fingerprint = fingerprint;
+}
+
+// True if artifact was never recorded or was built by a different command
+bool build_db_changed(const char *path, uint64_t fingerprint) {
+	if (build_db.count == 0) return true;
+	struct BuildDatabaseEntry *entry = build_db__find(path);
+	return entry->path == NULL || entry->fingerprint != fingerprint;
+}
+
+// Forget every fingerprint, next build_db_load() reads the file again
+void build_db_free(void) {
+	for (size_t i = 0; i < build_db.capacity; ++i) free((void*)build_db.slots[i].path);
+	free(build_db.slots);
+	memset(&build_db, 0, sizeof(build_db));
+}
+
+// Loaded fingerprints are kept while the file is the one they were read from or saved to,
+// a resident nob reloads them only after another process built
+enum RESULT build_db_load(const char *file_path) {
+	enum RESULT result = SUCCESS;
+	Nob_String_Builder sb = {0};
+	struct FileStat file = {0};
+	bool exists = file_stat(file_path, &file);
+	if (build_db.loaded) {
+		if (memcmp(&file, &build_db.file, sizeof(file)) == 0) nob_return_defer(SUCCESS);
+		build_db_free();
+	}
+	build_db.loaded = true;
+	build_db.file = file;
+	if (!exists) nob_return_defer(SUCCESS);
+	if (!nob_read_entire_file(file_path, &sb)) nob_return_defer(FAILED);
+	nob_sb_append_null(&sb);
+
+	size_t temp_checkpoint = nob_temp_save();
+	Nob_String_View content = nob_sv_from_parts(sb.items, sb.count - 1);
+	while (content.count > 0) {
+		Nob_String_View line = nob_sv_chop_by_delim(&content, '\n');
+		Nob_String_View hex = nob_sv_chop_by_delim(&line, ' ');
+		if (hex.count != 16 || line.count == 0) continue;
+		const char *hex_cstr = nob_temp_sv_to_cstr(hex);
+		char *end = NULL;
+		uint64_t fingerprint = strtoull(hex_cstr, &end, 16);
+		if (*end != '\0') continue;
+		build_db_set(nob_temp_sv_to_cstr(line), fingerprint);
+		nob_temp_rewind(temp_checkpoint);
+	}
+
+defer:
+	nob_sb_free(sb);
+	return result;
+}
+
+// Written next to `file_path` and renamed over it, interrupted build keeps the old database
+enum RESULT build_db_save(const char *file_path) {
+	enum RESULT result = SUCCESS;
+	Nob_String_Builder sb = {0};
+	size_t temp_checkpoint = nob_temp_save();
+	for (size_t i = 0; i < build_db.capacity; ++i) {
+		struct BuildDatabaseEntry *entry = &build_db.slots[i];
+		if (entry->path == NULL) continue;
+		nob_sb_appendf(&sb, "%016llx %s\n", (unsigned long long)entry->fingerprint, entry->path);
+	}
+	const char *tmp_path = nob_temp_sprintf("%s.tmp", file_path);
+	if (!nob_write_entire_file(tmp_path, sb.items, sb.count)) nob_return_defer(FAILED);
+	if (!nob_rename(tmp_path, file_path)) nob_return_defer(FAILED);
+	if (!file_stat(file_path, &build_db.file)) memset(&build_db.file, 0, sizeof(build_db.file));
+
+defer:
+	nob_temp_rewind(temp_checkpoint);
+	nob_sb_free(sb);
+	return result;
+}
+
+uint64_t build_fingerprint_cmd(const Nob_Cmd *cmd) {
+	uint64_t hash = HASH_SEED;
+	for (size_t i = 0; i < cmd->count; ++i) {
+		hash = hash_cstr(hash, cmd->items[i]);
+	}
+	return hash;
+}
+
+// Mark job as producing `output` with command fingerprint recorded once the job finishes
+void build_job_set_output(struct BuildGraph *graph, size_t job_id, const char *output, uint64_t fingerprint) {
+	graph->items[job_id].output = build_graph_strdup(graph, output);
+	graph->items[job_id].fingerprint = fingerprint;
+}
+
+// Output exists, was built by the same command and is newer than its inputs and outputs of its dependencies
+bool build_artifact_up_to_date(struct BuildGraph *graph, size_t job_id) {
+	struct BuildJob *job = &graph->items[job_id];
+	if (job->output == NULL) return false;
+	if (build_db_changed(job->output, job->fingerprint)) return false;
+
+	Nob_File_Paths inputs = {0};
+	nob_da_append_many(&inputs, job->inputs.items, job->inputs.count);
+	for (size_t i = 0; i < job->deps.count; ++i) {
+		const char *dep_output = graph->items[job->deps.items[i]].output;
+		if (dep_output != NULL) nob_da_append(&inputs, dep_output);
+	}
+	int rebuild_is_needed = nob_needs_rebuild(job->output, inputs.items, inputs.count);
+	nob_da_free(inputs);
+	return rebuild_is_needed == 0;
+}
+
+// Add job producing `output`, fingerprinted with its own command.
+// It is skipped while build_artifact_up_to_date() and no dependency ran.
+size_t build_add_artifact_job(struct BuildGraph *graph, const char *output, Nob_Cmd *cmd) {
+	uint64_t fingerprint = build_fingerprint_cmd(cmd);
+	size_t job_id = build_graph_add_job(graph, output, cmd);
+	build_job_set_output(graph, job_id, output, fingerprint);
+	graph->items[job_id].up_to_date = build_artifact_up_to_date;
+	return job_id;
+}
+
+static bool build__remove_output(struct BuildGraph *graph, size_t job_id) {
+	const char *output = graph->items[job_id].output;
+	if (nob_file_exists(output) != 1) return true;
+	return nob_delete_file(output);
+}
+
+// Static library job, see build_add_artifact_job(). Archive is recreated, not updated,
+// so members of objects that are no longer built (like after switching -unity) don't stay in it.
+size_t build_add_archive_job(struct BuildGraph *graph, const char *output, Nob_Cmd *cmd) {
+	size_t job_id = build_add_artifact_job(graph, output, cmd);
+	graph->items[job_id].before_start = build__remove_output;
+	return job_id;
+}
+
+static enum BUILD_STEP build__rename_staged_output(struct BuildGraph *graph, size_t job_id) {
+	struct BuildJob *job = &graph->items[job_id];
+	if (!nob_rename((const char*)job->data, job->output)) return BUILD_STEP_FAILED;
+	return BUILD_STEP_DONE;
+}
+
+// Artifact job whose command writes `staging_output`, renamed over `output` once it is complete.
+// Programs loading `output` while running (plugin hot reload) never see a half written file.
+size_t build_add_staged_artifact_job(struct BuildGraph *graph, const char *output, const char *staging_output, Nob_Cmd *cmd) {
+	size_t job_id = build_add_artifact_job(graph, output, cmd);
+	graph->items[job_id].data = (void*)build_graph_strdup(graph, staging_output);
+	graph->items[job_id].on_done = build__rename_staged_output;
+	return job_id;
+}
+
+// Files must outlive the graph or be graph owned (like paths from nob_cmd_process_source_dir())
+void build_job_add_inputs(struct BuildGraph *graph, size_t job_id, Nob_File_Paths *files) {
+	nob_da_append_many(&graph->items[job_id].inputs, files->items, files->count);
+}
+
+// Store fingerprints of every artifact the graph has built
+void build_db_record(struct BuildGraph *graph) {
+	for (size_t i = 0; i < graph->count; ++i) {
+		struct BuildJob *job = &graph->items[i];
+		if (job->output == NULL || job->state != BUILD_JOB_DONE) continue;
+		build_db_set(job->output, job->fingerprint);
+	}
+}
+
+// Content addressed object cache.
+// Object is stored as `<dir><hash>.o`, hash covers preprocessed source, compiler arguments and compiler version.
+// Same source with same flags compiles once, even after switching configs or cleaning OBJ_FOLDER.
+struct BuildCache {
+	bool enabled;
+	const char *dir;             // With trailing slash
+	size_t max_size;             // Bytes, least recently used objects are evicted above it
+	const char *compiler;        // Compiler `compiler_hash` belongs to
+	uint64_t compiler_hash;
+	size_t hits;
+	size_t misses;
+	size_t evicted;
+};
+
+static struct BuildCache build_cache = {0};
+
+// Object job first preprocesses the source, hook then either copies cached object or runs the compile
+struct BuildCacheJob {
+	Nob_Cmd compile_cmd;         // Arguments are graph owned
+	const char *object_path;
+	const char *preprocessed_path;
+	uint64_t hash;
+	bool compiling;
+	bool refresh;                // Forced rebuild, compile and store without looking up
+};
+
+static enum RESULT build_cache__compiler_hash(const char *compiler, uint64_t *hash) {
+	enum RESULT result = SUCCESS;
+	Nob_Cmd cmd = {0};
+	if (build_cache.compiler != NULL && strcmp(build_cache.compiler, compiler) == 0) {
+		*hash = build_cache.compiler_hash;
+		nob_return_defer(SUCCESS);
+	}
+	const char *version_path = nob_temp_sprintf("%scompiler_version.txt", build_cache.dir);
+	nob_cmd_append(&cmd, compiler, "--version");
+	if (!nob_cmd_run(&cmd, .stdout_path = version_path)) nob_return_defer(FAILED);
+	build_cache.compiler_hash = hash_cstr(HASH_SEED, compiler);
+	if (hash_file(&build_cache.compiler_hash, version_path) == FAILED) nob_return_defer(FAILED);
+	free((void*)build_cache.compiler);
+	build_cache.compiler = strdup(compiler);
+	*hash = build_cache.compiler_hash;
+
+defer:
+	nob_cmd_free(cmd);
+	return result;
+}
+
+static enum BUILD_STEP build_cache__job_done(struct BuildGraph *graph, size_t job_id) {
+	struct BuildJob *job = &graph->items[job_id];
+	struct BuildCacheJob *data = (struct BuildCacheJob*)job->data;
+	enum BUILD_STEP result = BUILD_STEP_DONE;
+	size_t temp_checkpoint = nob_temp_save();
+
+	if (data->compiling) {
+		// Fresh object, store it. Failing to store only costs a future hit.
+		const char *cached_path = nob_temp_sprintf("%s%016llx.o", build_cache.dir, (unsigned long long)data->hash);
+		const char *tmp_path = nob_temp_sprintf("%s.tmp", cached_path);
+		if (nob_copy_file(data->object_path, tmp_path) && !nob_rename(tmp_path, cached_path)) {
+			nob_delete_file(tmp_path);
+		}
+		nob_return_defer(BUILD_STEP_DONE);
+	}
+
+	uint64_t hash = HASH_SEED;
+	if (build_cache__compiler_hash(data->compile_cmd.items[0], &hash) == FAILED) nob_return_defer(BUILD_STEP_FAILED);
+	if (hash_file(&hash, data->preprocessed_path) == FAILED) nob_return_defer(BUILD_STEP_FAILED);
+	nob_delete_file(data->preprocessed_path);
+	// Output paths don't change the object, everything else might
+	for (size_t i = 0; i < data->compile_cmd.count; ++i) {
+		const char *arg = data->compile_cmd.items[i];
+		if (strcmp(arg, "-o") == 0 || strcmp(arg, "-MF") == 0 || strcmp(arg, "-MT") == 0) {
+			i += 1;
+			continue;
+		}
+		hash = hash_cstr(hash, arg);
+	}
+	data->hash = hash;
+
+	const char *cached_path = nob_temp_sprintf("%s%016llx.o", build_cache.dir, (unsigned long long)hash);
+	if (!data->refresh && nob_file_exists(cached_path) == 1) {
+		if (!nob_copy_file(cached_path, data->object_path)) nob_return_defer(BUILD_STEP_FAILED);
+		// Modification time is the LRU clock
+		utime(cached_path, NULL);
+		build_cache.hits += 1;
+		nob_return_defer(BUILD_STEP_DONE);
+	}
+
+	if (!data->refresh) build_cache.misses += 1;
+	data->compiling = true;
+	job->cmd.count = 0;
+	nob_da_append_many(&job->cmd, data->compile_cmd.items, data->compile_cmd.count);
+	result = BUILD_STEP_AGAIN;
+
+defer:
+	nob_temp_rewind(temp_checkpoint);
+	return result;
+}
+
+// Add object job that goes through build_cache. `compile_cmd` must be `cc -c <src> -o <obj> ...`, it is reset like build_graph_add_job() does.
+// With `refresh` the object always compiles, the cached copy is only replaced.
+size_t build_cache_add_compile_job(struct BuildGraph *graph, const char *object_path, Nob_Cmd *compile_cmd, bool refresh) {
+	struct BuildCacheJob *data = (struct BuildCacheJob*)build_graph_alloc(graph, sizeof(*data));
+	data->refresh = refresh;
+	data->object_path = build_graph_strdup(graph, object_path);
+	data->preprocessed_path = build_graph_strdup(graph, nob_temp_sprintf("%s.i", object_path));
+	data->compile_cmd.items = (const char**)build_graph_alloc(graph, compile_cmd->count * sizeof(*compile_cmd->items));
+	data->compile_cmd.count = compile_cmd->count;
+	data->compile_cmd.capacity = compile_cmd->count;
+
+	// Same arguments, but only preprocess. Dependency file gets written here with the object as its target.
+	Nob_Cmd preprocess_cmd = {0};
+	for (size_t i = 0; i < compile_cmd->count; ++i) {
+		const char *arg = compile_cmd->items[i];
+		data->compile_cmd.items[i] = build_graph_strdup(graph, arg);
+		if (strcmp(arg, "-c") == 0) {
+			nob_cmd_append(&preprocess_cmd, "-E");
+		}
+		else if (strcmp(arg, "-o") == 0 && i + 1 < compile_cmd->count) {
+			nob_cmd_append(&preprocess_cmd, "-o", data->preprocessed_path);
+			data->compile_cmd.items[i + 1] = build_graph_strdup(graph, compile_cmd->items[i + 1]);
+			i += 1;
+		}
+		else {
+			nob_cmd_append(&preprocess_cmd, arg);
+		}
+	}
+	nob_cmd_append(&preprocess_cmd, "-MT", data->object_path);
+
+	size_t job_id = build_graph_add_job(graph, object_path, &preprocess_cmd);
+	graph->items[job_id].on_done = build_cache__job_done;
+	graph->items[job_id].data = data;
+	compile_cmd->count = 0;
+	nob_cmd_free(preprocess_cmd);
+	return job_id;
+}
+
+struct BuildCacheEntry {
+	const char *path;
+	size_t size;
+	time_t last_used;
+};
+
+static int build_cache__entry_compare(const void *a, const void *b) {
+	const struct BuildCacheEntry *entry_a = (const struct BuildCacheEntry*)a;
+	const struct BuildCacheEntry *entry_b = (const struct BuildCacheEntry*)b;
+	if (entry_a->last_used < entry_b->last_used) return -1;
+	if (entry_a->last_used > entry_b->last_used) return 1;
+	return 0;
+}
+
+// Evict least recently used objects until cache fits in `max_size`. `total_size` receives what's left.
+enum RESULT build_cache_trim(size_t *total_size) {
+	enum RESULT result = SUCCESS;
+	Nob_File_Paths children = {0};
+	struct {
+		struct BuildCacheEntry *items;
+		size_t count;
+		size_t capacity;
+	} entries = {0};
+	size_t temp_checkpoint = nob_temp_save();
+	*total_size = 0;
+	if (!nob_read_entire_dir(build_cache.dir, &children)) nob_return_defer(FAILED);
+
+	for (size_t i = 0; i < children.count; ++i) {
+		if (!nob_sv_end_with(nob_sv_from_cstr(children.items[i]), ".o")) continue;
+		struct BuildCacheEntry entry = {0};
+		entry.path = nob_temp_sprintf("%s%s", build_cache.dir, children.items[i]);
+		struct stat statbuf = {0};
+		if (stat(entry.path, &statbuf) < 0) continue;
+		entry.size = (size_t)statbuf.st_size;
+		entry.last_used = statbuf.st_mtime;
+		*total_size += entry.size;
+		nob_da_append(&entries, entry);
+	}
+	if (*total_size <= build_cache.max_size) nob_return_defer(SUCCESS);
+
+	qsort(entries.items, entries.count, sizeof(*entries.items), build_cache__entry_compare);
+	for (size_t i = 0; i < entries.count && *total_size > build_cache.max_size; ++i) {
+		if (!nob_delete_file(entries.items[i].path)) continue;
+		*total_size -= entries.items[i].size;
+		build_cache.evicted += 1;
+	}
+
+defer:
+	nob_temp_rewind(temp_checkpoint);
+	nob_da_free(children);
+	nob_da_free(entries);
+	return result;
+}
+
+// Trim the cache and print hit/miss statistics
+void build_cache_report(void) {
+	if (!build_cache.enabled) return;
+	size_t total_size = 0;
+	build_cache_trim(&total_size);
+	size_t lookups = build_cache.hits + build_cache.misses;
+	nob_log(NOB_INFO, "Object cache: %zu hits, %zu misses (%.0f%% hit rate), %zu evicted, %.1f of %.1f MiB used",
+		build_cache.hits, build_cache.misses, lookups > 0 ? 100.0 * build_cache.hits / lookups : 0.0, build_cache.evicted,
+		total_size / (1024.0 * 1024.0), build_cache.max_size / (1024.0 * 1024.0));
+}
+
+// Resident memo - -watch and -daemon plan many builds in one process. Parsed dependency files are
+// reused while the depfile is unchanged, stats of files inside watched directories until inotify
+// reports them with build_memo_forget(). Anything else is read from disk every time.
+struct BuildMemoEntry {
+	const char *path;            // NULL for empty slot
+	struct FileStat stat;        // Of the file itself, or of the depfile `deps` were parsed from
+	Nob_File_Paths deps;         // Owned strings, depfiles only
+	bool valid;
+};
+
+struct BuildMemoTable {
+	struct BuildMemoEntry *slots; // Open addressing, capacity is power of two
+	size_t count;
+	size_t capacity;
+};
+
+struct BuildMemo {
+	bool enabled;
+	struct BuildMemoTable stats;
+	struct BuildMemoTable depfiles;
+	Nob_File_Paths watched_dirs; // Owned, normalized by build_memo__key()
+};
+
+static struct BuildMemo build_memo = {0};
+
+// Same file spelled the same way: no `./`, repeated or trailing slashes (temp string)
+static const char *build_memo__key(const char *path) {
+	Nob_String_Builder sb = {0};
+	while (path[0] == '.' && path[1] == '/') path += 2;
+	for (const char *it = path; *it != '\0'; ++it) {
+		if (*it == '/' && (it[1] == '/' || it[1] == '\0') && sb.count > 0) continue;
+		nob_da_append(&sb, *it);
+	}
+	const char *key = nob_temp_strndup(sb.items != NULL ? sb.items : "", sb.count);
+	nob_sb_free(sb);
+	return key;
+}
+
+static struct BuildMemoEntry *build_memo__find(struct BuildMemoTable *table, const char *key) {
+	if (table->count * 2 >= table->capacity) {
+		struct BuildMemoTable old = *table;
+		table->capacity = old.capacity == 0 ? 256 : old.capacity * 2;
+		table->slots = (struct BuildMemoEntry*)calloc(table->capacity, sizeof(*table->slots));
+		NOB_ASSERT(table->slots != NULL && "Buy more RAM lol");
+		for (size_t i = 0; i < old.capacity; ++i) {
+			if (old.slots[i].path != NULL) *build_memo__find(table, old.slots[i].path) = old.slots[i];
+		}
+		free(old.slots);
+	}
+	size_t mask = table->capacity - 1;
+	size_t i = (size_t)hash_cstr(HASH_SEED, key) & mask;
+	while (table->slots[i].path != NULL && strcmp(table->slots[i].path, key) != 0) {
+		i = (i + 1) & mask;
+	}
+	if (table->slots[i].path == NULL) {
+		table->slots[i].path = strdup(key);
+		NOB_ASSERT(table->slots[i].path != NULL && "Buy more RAM lol");
+		table->count += 1;
+	}
+	return &table->slots[i];
+}
+
+static void build_memo__clear(struct BuildMemoTable *table) {
+	for (size_t i = 0; i < table->capacity; ++i) {
+		struct BuildMemoEntry *entry = &table->slots[i];
+		for (size_t j = 0; j < entry->deps.count; ++j) free((void*)entry->deps.items[j]);
+		nob_da_free(entry->deps);
+		free((void*)entry->path);
+	}
+	free(table->slots);
+	memset(table, 0, sizeof(*table));
+}
+
+void build_memo_enable(void) {
+	build_memo.enabled = true;
+}
+
+// inotify watches `dir`, stats of files directly inside it can be kept
+void build_memo_watch_dir(const char *dir) {
+	size_t temp_checkpoint = nob_temp_save();
+	nob_da_append(&build_memo.watched_dirs, strdup(build_memo__key(dir)));
+	nob_temp_rewind(temp_checkpoint);
+}
+
+// inotify reported `path`. `NULL` forgets every stat, for directories moved with everything inside them.
+void build_memo_forget(const char *path) {
+	if (path == NULL) {
+		build_memo__clear(&build_memo.stats);
+		return;
+	}
+	if (build_memo.stats.count == 0) return;
+	size_t temp_checkpoint = nob_temp_save();
+	build_memo__find(&build_memo.stats, build_memo__key(path))->valid = false;
+	nob_temp_rewind(temp_checkpoint);
+}
+
+void build_memo_free(void) {
+	build_memo__clear(&build_memo.stats);
+	build_memo__clear(&build_memo.depfiles);
+	for (size_t i = 0; i < build_memo.watched_dirs.count; ++i) free((void*)build_memo.watched_dirs.items[i]);
+	nob_da_free(build_memo.watched_dirs);
+	memset(&build_memo, 0, sizeof(build_memo));
+}
+
+static bool build_memo__watched(const char *key) {
+	const char *slash = strrchr(key, '/');
+	size_t dir_length = slash != NULL ? (size_t)(slash - key) : 0;
+	for (size_t i = 0; i < build_memo.watched_dirs.count; ++i) {
+		const char *dir = build_memo.watched_dirs.items[i];
+		if (strlen(dir) == dir_length && strncmp(dir, key, dir_length) == 0) return true;
+	}
+	return false;
+}
+
+// file_stat() answered from the memo when inotify would have reported a change
+bool build_memo_stat(const char *path, struct FileStat *stat) {
+	if (!build_memo.enabled) return file_stat(path, stat);
+	size_t temp_checkpoint = nob_temp_save();
+	const char *key = build_memo__key(path);
+	bool result = true;
+	if (!build_memo__watched(key)) {
+		result = file_stat(path, stat);
+	}
+	else {
+		struct BuildMemoEntry *entry = build_memo__find(&build_memo.stats, key);
+		if (!entry->valid) {
+			entry->valid = file_stat(path, &entry->stat);
+		}
+		*stat = entry->stat;
+		result = entry->valid;
+	}
+	nob_temp_rewind(temp_checkpoint);
+	return result;
+}
+
+// nob_parse_dependency_file() parsing each depfile once while it stays the same.
+// With the memo on `deps` receives strings owned by it, valid until the next call for `dep_path`.
+enum RESULT build_memo_dependencies(const char *dep_path, Nob_File_Paths *deps) {
+	if (!build_memo.enabled) return nob_parse_dependency_file(dep_path, deps);
+	size_t temp_checkpoint = nob_temp_save();
+	struct FileStat now = {0};
+	enum RESULT result = SUCCESS;
+	if (!file_stat(dep_path, &now)) nob_return_defer(FAILED);
+	struct BuildMemoEntry *entry = build_memo__find(&build_memo.depfiles, build_memo__key(dep_path));
+	if (!entry->valid || memcmp(&entry->stat, &now, sizeof(now)) != 0) {
+		Nob_File_Paths parsed = {0};
+		entry->valid = false;
+		if (nob_parse_dependency_file(dep_path, &parsed) == FAILED) {
+			nob_da_free(parsed);
+			nob_return_defer(FAILED);
+		}
+		for (size_t i = 0; i < entry->deps.count; ++i) free((void*)entry->deps.items[i]);
+		entry->deps.count = 0;
+		for (size_t i = 0; i < parsed.count; ++i) nob_da_append(&entry->deps, strdup(parsed.items[i]));
+		nob_da_free(parsed);
+		entry->stat = now;
+		entry->valid = true;
+	}
+	nob_da_append_many(deps, entry->deps.items, entry->deps.count);
+
+defer:
+	nob_temp_rewind(temp_checkpoint);
+	return result;
+}
+
+// nob_needs_rebuild_dependency_file() through the memo: 1 when `output_path` is older than
+// its source or a prerequisite, or when one of them or the depfile is missing
+int build_needs_rebuild_dependency_file(const char *output_path, const char *source_path, const char *dep_path) {
+	if (!build_memo.enabled) return nob_needs_rebuild_dependency_file(output_path, source_path, dep_path);
+	int result = 0;
+	Nob_File_Paths deps = {0};
+	struct FileStat output = {0};
+	struct FileStat input = {0};
+	if (!file_stat(output_path, &output)) nob_return_defer(1);
+	if (build_memo_dependencies(dep_path, &deps) == FAILED) nob_return_defer(1);
+	nob_da_append(&deps, source_path);
+	for (size_t i = 0; i < deps.count; ++i) {
+		if (!build_memo_stat(deps.items[i], &input)) nob_return_defer(1);
+		// Whole seconds like nob_needs_rebuild()
+		if (input.mtime_ns / 1000000000ULL > output.mtime_ns / 1000000000ULL) nob_return_defer(1);
+	}
+
+defer:
+	nob_da_free(deps);
+	return result;
+}
+
+// Filesystem snapshot - inode, size and mtime of everything a successful build read or wrote.
+// When none of them changed and arguments are the same, the build can't do anything and nob exits
+// before touching the filesystem. Stored binary: header, entries, then NUL separated paths.
+#define SNAPSHOT_MAGIC 0x32504e5342424f4eULL   // "NOBBSNP2"
+// Below it one thread checks the snapshot faster than starting more
+#define SNAPSHOT_ENTRIES_PER_THREAD 512
+
+struct SnapshotHeader {
+	uint64_t magic;
+	uint64_t key;                // Hash of arguments the snapshot was built with
+	uint64_t count;
+	uint64_t paths_size;
+};
+
+struct Snapshot {
+	Nob_File_Paths paths;        // Owned, collected while building
+	Nob_File_Paths depfiles;     // Owned, their prerequisites are added on save
+	Nob_File_Paths outputs;      // Owned, written by nob or the build so allowed to be newer than run_start_ns
+	uint64_t run_start_ns;       // Wall clock when the graph started running, 0 skips the input check
+};
+
+static struct Snapshot build_snapshot = {0};
+
+// File or directory whose change must trigger a real build (directories catch added/removed files)
+void build_snapshot_add(const char *path) {
+	nob_da_append(&build_snapshot.paths, strdup(path));
+}
+
+// File the build or nob's planning writes (generated headers and sources too)
+void build_snapshot_add_output(const char *path) {
+	build_snapshot_add(path);
+	nob_da_append(&build_snapshot.outputs, strdup(path));
+}
+
+// Object's dependency file, it and every prerequisite in it are added on save
+void build_snapshot_add_depfile(const char *dep_path) {
+	nob_da_append(&build_snapshot.depfiles, strdup(dep_path));
+}
+
+// Outputs and inputs of every job
+void build_snapshot_add_graph(struct BuildGraph *graph) {
+	for (size_t i = 0; i < graph->count; ++i) {
+		struct BuildJob *job = &graph->items[i];
+		if (job->output != NULL) build_snapshot_add_output(job->output);
+		for (size_t j = 0; j < job->inputs.count; ++j) build_snapshot_add(job->inputs.items[j]);
+	}
+}
+
+// Call right before running the graph. Inputs edited after it may have been read
+// before the edit, so a snapshot of their new stats would hide the change.
+void build_snapshot_run_begin(void) {
+#if defined(_WIN32)
+	build_snapshot.run_start_ns = (uint64_t)time(NULL) * 1000000000ULL;
+#else
+	// Files written before now never get a later stamp. Kernels stamping from the coarse clock
+	// can give an edit in the first tick after now an earlier one.
+	struct timespec now;
+	clock_gettime(CLOCK_REALTIME, &now);
+	build_snapshot.run_start_ns = (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+#endif
+}
+
+void build_snapshot_free(void) {
+	for (size_t i = 0; i < build_snapshot.paths.count; ++i) free((void*)build_snapshot.paths.items[i]);
+	for (size_t i = 0; i < build_snapshot.depfiles.count; ++i) free((void*)build_snapshot.depfiles.items[i]);
+	for (size_t i = 0; i < build_snapshot.outputs.count; ++i) free((void*)build_snapshot.outputs.items[i]);
+	nob_da_free(build_snapshot.paths);
+	nob_da_free(build_snapshot.depfiles);
+	nob_da_free(build_snapshot.outputs);
+	memset(&build_snapshot, 0, sizeof(build_snapshot));
+}
+
+static int snapshot__compare_paths(const void *a, const void *b) {
+	return strcmp(*(const char**)a, *(const char**)b);
+}
+
+static int snapshot__find_path(const void *key, const void *item) {
+	return strcmp((const char*)key, *(const char**)item);
+}
+
+// Write collected paths as they are now, call only after a successful build.
+// Nothing is written when an input changed while the graph ran.
+enum RESULT build_snapshot_save(const char *file_path, uint64_t key) {
+	enum RESULT result = SUCCESS;
+	Nob_File_Paths deps = {0};
+	Nob_String_Builder entries = {0};
+	Nob_String_Builder paths = {0};
+	size_t temp_checkpoint = nob_temp_save();
+
+	for (size_t i = 0; i < build_snapshot.depfiles.count; ++i) {
+		const char *dep_path = build_snapshot.depfiles.items[i];
+		build_snapshot_add_output(dep_path);
+		deps.count = 0;
+		if (build_memo_dependencies(dep_path, &deps) == FAILED) nob_return_defer(FAILED);
+		for (size_t j = 0; j < deps.count; ++j) build_snapshot_add(deps.items[j]);
+		nob_temp_rewind(temp_checkpoint);
+	}
+	qsort(build_snapshot.paths.items, build_snapshot.paths.count, sizeof(*build_snapshot.paths.items), snapshot__compare_paths);
+	qsort(build_snapshot.outputs.items, build_snapshot.outputs.count, sizeof(*build_snapshot.outputs.items), snapshot__compare_paths);
+
+	struct SnapshotHeader header = {SNAPSHOT_MAGIC, key, 0, 0};
+	for (size_t i = 0; i < build_snapshot.paths.count; ++i) {
+		const char *path = build_snapshot.paths.items[i];
+		if (i > 0 && strcmp(path, build_snapshot.paths.items[i - 1]) == 0) continue;
+		struct FileStat entry = {0};
+		// Every path was just built or read, one missing now means something else is going on
+		if (!file_stat(path, &entry)) {
+			nob_log(NOB_WARNING, "No build snapshot, %s is missing", path);
+			nob_return_defer(FAILED);
+		}
+		// Next build has to see the edit, the previous snapshot doesn't match it either
+		if (build_snapshot.run_start_ns != 0 && entry.mtime_ns >= build_snapshot.run_start_ns &&
+			bsearch(path, build_snapshot.outputs.items, build_snapshot.outputs.count, sizeof(*build_snapshot.outputs.items), snapshot__find_path) == NULL) {
+			nob_log(NOB_INFO, "No build snapshot, %s changed during the build", path);
+			nob_return_defer(SUCCESS);
+		}
+		nob_sb_append_buf(&entries, &entry, sizeof(entry));
+		nob_sb_append_buf(&paths, path, strlen(path) + 1);
+		header.count += 1;
+	}
+	header.paths_size = paths.count;
+
+	Nob_String_Builder sb = {0};
+	nob_sb_append_buf(&sb, &header, sizeof(header));
+	nob_sb_append_buf(&sb, entries.items, entries.count);
+	nob_sb_append_buf(&sb, paths.items, paths.count);
+	const char *tmp_path = nob_temp_sprintf("%s.tmp", file_path);
+	bool written = nob_write_entire_file(tmp_path, sb.items, sb.count) && nob_rename(tmp_path, file_path);
+	nob_sb_free(sb);
+	if (!written) nob_return_defer(FAILED);
+
+defer:
+	nob_temp_rewind(temp_checkpoint);
+	nob_da_free(deps);
+	nob_sb_free(entries);
+	nob_sb_free(paths);
+	return result;
+}
+
+struct SnapshotCheck {
+	const struct FileStat *entries;
+	const char **paths;
+	size_t begin;
+	size_t end;
+	bool changed;
+};
+
+static void *snapshot__check(void *arg) {
+	struct SnapshotCheck *check = (struct SnapshotCheck*)arg;
+	for (size_t i = check->begin; i < check->end; ++i) {
+		struct FileStat now = {0};
+		const struct FileStat *then = &check->entries[i];
+		if (!file_stat(check->paths[i], &now) || now.device != then->device || now.inode != then->inode || now.size != then->size || now.mtime_ns != then->mtime_ns) {
+			check->changed = true;
+			break;
+		}
+	}
+	return NULL;
+}
+
+// True when snapshot exists, was saved with `key` and nothing in it changed.
+// `checked` receives number of paths compared.
+bool build_snapshot_unchanged(const char *file_path, uint64_t key, size_t *checked) {
+	bool result = false;
+	Nob_String_Builder sb = {0};
+	const char **paths = NULL;
+	*checked = 0;
+	if (nob_file_exists(file_path) != 1) return false;
+	if (!nob_read_entire_file(file_path, &sb)) return false;
+	if (sb.count < sizeof(struct SnapshotHeader)) nob_return_defer(false);
+
+	struct SnapshotHeader header;
+	memcpy(&header, sb.items, sizeof(header));
+	size_t entries_size = header.count * sizeof(struct FileStat);
+	if (header.magic != SNAPSHOT_MAGIC || header.key != key) nob_return_defer(false);
+	if (sb.count != sizeof(header) + entries_size + header.paths_size) nob_return_defer(false);
+	if (header.paths_size == 0 || sb.items[sb.count - 1] != '\0') nob_return_defer(false);
+
+	// Entries are 8 byte aligned inside the buffer
+	const struct FileStat *entries = (const struct FileStat*)(sb.items + sizeof(header));
+	paths = (const char**)malloc(header.count * sizeof(*paths));
+	NOB_ASSERT(paths != NULL && "Buy more RAM lol");
+	const char *it = sb.items + sizeof(header) + entries_size;
+	for (size_t i = 0; i < header.count; ++i) {
+		if (it >= sb.items + sb.count) nob_return_defer(false);
+		paths[i] = it;
+		it += strlen(it) + 1;
+	}
+
+	struct SnapshotCheck checks[16] = {0};
+	size_t thread_count = header.count / SNAPSHOT_ENTRIES_PER_THREAD + 1;
+	if (thread_count > NOB_ARRAY_LEN(checks)) thread_count = NOB_ARRAY_LEN(checks);
+	if (thread_count > (size_t)nob_nprocs()) thread_count = (size_t)nob_nprocs();
+	if (thread_count < 1) thread_count = 1;
+	for (size_t i = 0; i < thread_count; ++i) {
+		checks[i] = (struct SnapshotCheck){entries, paths, header.count * i / thread_count, header.count * (i + 1) / thread_count, false};
+	}
+#if !defined(_WIN32)
+	pthread_t threads[NOB_ARRAY_LEN(checks)];
+	size_t started = 1;
+	for (; started < thread_count; ++started) {
+		if (pthread_create(&threads[started], NULL, snapshot__check, &checks[started]) != 0) break;
+	}
+	snapshot__check(&checks[0]);
+	// Ranges of threads that didn't start
+	for (size_t i = started; i < thread_count; ++i) snapshot__check(&checks[i]);
+	for (size_t i = 1; i < started; ++i) pthread_join(threads[i], NULL);
+#else
+	// TODO: thread pool on Windows
+	for (size_t i = 0; i < thread_count; ++i) snapshot__check(&checks[i]);
+#endif
+	result = true;
+	for (size_t i = 0; i < thread_count; ++i) {
+		if (checks[i].changed) result = false;
+	}
+	*checked = header.count;
+
+defer:
+	free(paths);
+	nob_sb_free(sb);
+	return result;
+}
+
+// Precompiled headers - one wrapper header including a module's heavy headers is compiled per configuration,
+// modules opt in with build_pch_add_job() before queuing their objects.
+struct BuildPch {
+	bool enabled;
+	const char *dir;             // Per configuration, holds wrapper headers and their precompiled output
+};
+
+static struct BuildPch build_pch = {0};
+
+// Suffix the compiler looks for next to a force included header, depends on the compiler nob runs
+static const char *build_pch__extension(void) {
+	return cc_family() == CC_FAMILY_CLANG ? ".pch" : ".gch";
+}
+
+// Precompile `headers` as `<build_pch.dir><name>.h` with flags of `item_cmd`, then force include it in item_cmd.
+// Add every flag to item_cmd before, precompiled header is only used with identical flags.
+enum RESULT build_pch_add_job(struct BuildGraph *graph, Nob_Cmd *item_cmd, const char *name, const char **headers, size_t headers_count, bool debug, bool shared, bool force_rebuild) {
+	enum RESULT result = SUCCESS;
+	Nob_String_Builder sb = {0};
+	Nob_String_Builder existing = {0};
+	Nob_Cmd pch_cmd = {0};
+	size_t temp_checkpoint = nob_temp_save();
+	if (!build_pch.enabled) nob_return_defer(SUCCESS);
+#if defined(_MSC_VER)
+	// TODO: MSVC /Yc /Yu needs a source file creating the .pch
+	nob_return_defer(SUCCESS);
+#endif
+	if (!nob_mkdir_if_not_exists(build_pch.dir)) nob_return_defer(FAILED);
+
+	const char *header_path = nob_temp_sprintf("%s%s.h", build_pch.dir, name);
+	const char *pch_path = nob_temp_sprintf("%s%s", header_path, build_pch__extension());
+	const char *dep_path = nob_temp_sprintf("%s%s.d", build_pch.dir, name);
+
+	// Rewriting unchanged wrapper would rebuild every object including it
+	nob_sb_appendf(&sb, "// Generated by nob for precompiled header, don't edit\n");
+	for (size_t i = 0; i < headers_count; ++i) {
+		nob_sb_appendf(&sb, "#include \"%s\"\n", headers[i]);
+	}
+	if (nob_file_exists(header_path) != 1 || !nob_read_entire_file(header_path, &existing) ||
+		existing.count != sb.count || memcmp(existing.items, sb.items, sb.count) != 0) {
+		if (!nob_write_entire_file(header_path, sb.items, sb.count)) nob_return_defer(FAILED);
+	}
+	build_snapshot_add_output(header_path);
+
+	nob_cc(&pch_cmd);
+	nob_cmd_append(&pch_cmd, "-x", "c-header", header_path);
+	nob_cmd_append(&pch_cmd, "-o", pch_path);
+	nob_cmd_dependency_file(&pch_cmd, dep_path);
+	if (shared) nob_cmd_append(&pch_cmd, "-fpic");
+	if (debug) nob_cmd_append(&pch_cmd, "-g");
+	nob_cmd_append_cmd(&pch_cmd, item_cmd);
+	uint64_t fingerprint = build_fingerprint_cmd(&pch_cmd);
+
+	int rebuild_is_needed = build_needs_rebuild_dependency_file(pch_path, header_path, dep_path);
+	if (rebuild_is_needed < 0) nob_return_defer(FAILED);
+	if (rebuild_is_needed != 0 || force_rebuild || build_db_changed(pch_path, fingerprint)) {
+		size_t pch_job = build_graph_add_job(graph, pch_path, &pch_cmd);
+		build_job_set_output(graph, pch_job, pch_path, fingerprint);
+	}
+	build_snapshot_add_output(pch_path);
+	build_snapshot_add_depfile(dep_path);
+
+	// Compiler picks `name.h` + build_pch__extension() next to the wrapper, falls back to the wrapper itself
+	nob_cmd_append(item_cmd, "-Winvalid-pch", "-include", build_graph_strdup(graph, header_path));
+
+defer:
+	nob_temp_rewind(temp_checkpoint);
+	nob_sb_free(sb);
+	nob_sb_free(existing);
+	nob_cmd_free(pch_cmd);
+	return result;
+}
+
+// Queued precompiled header job `cmd` force includes, BUILD_JOB_NONE when there is none
+static size_t build_pch__find_job(struct BuildGraph *graph, const Nob_Cmd *cmd) {
+	for (size_t i = 0; i + 1 < cmd->count; ++i) {
+		if (strcmp(cmd->items[i], "-include") != 0) continue;
+		size_t header_length = strlen(cmd->items[i + 1]);
+		for (size_t job_id = 0; job_id < graph->count; ++job_id) {
+			const char *output = graph->items[job_id].output;
+			if (output == NULL || strncmp(output, cmd->items[i + 1], header_length) != 0) continue;
+			if (strcmp(output + header_length, build_pch__extension()) == 0) return job_id;
+		}
+	}
+	return BUILD_JOB_NONE;
+}
+
+// Queue object jobs for the stale ones of `file_names` (names inside `source_dir`, like nob_fetch_files() gives).
+// `objects` receives every object path (graph owned strings) and
+// `objects_job` a group job that finishes when all of them are compiled.
+enum RESULT nob_cmd_process_source_files(struct BuildGraph *graph, Nob_Cmd *item_cmd, const char *source_dir, Nob_File_Paths *file_names, const char *output_dir, const char *src_extension, bool debug, bool shared, bool force_rebuild, Nob_File_Paths *objects, size_t *objects_job) {
+	enum RESULT result = SUCCESS;
+	Nob_Cmd obj_cmd = {0};
+	int rebuild_is_needed;
+	size_t temp_checkpoint = nob_temp_save();
+	*objects_job = build_graph_add_job(graph, nob_temp_sprintf("objects %s", source_dir), NULL);
+	size_t pch_job = build_pch__find_job(graph, item_cmd);
+	if (!nob_mkdir_if_not_exists(output_dir)) nob_return_defer(FAILED);
+
+	const char *src_name;
+	const char *src_file_path;
+	const char *bin_path;
+	const char *dep_path;
+	Nob_String_View src_file;
+	for (size_t i = 0; i < file_names->count; ++i) {
+		// Names can have directories (`os/unix.c`), objects mirror them inside output_dir
+		src_file = nob_sv_from_cstr(file_names->items[i]);
+		if (nob_sv_end_with(src_file, src_extension)) src_file.count -= strlen(src_extension);
+		src_name = nob_temp_cstr_from_string_view(&src_file);
+		src_file_path = nob_temp_sprintf("%s%s", source_dir, file_names->items[i]);
+		// TODO: Add MSVC obj
+		bin_path = nob_temp_sprintf("%s%s.o", output_dir, src_name);
+		if (bin_path == NULL) {
+			nob_log(NOB_ERROR, "Failed to allocate binary file path cstr: %s", nob_temp_sprintf("%s%s.o", output_dir, src_name));
+			assert(false);
+			nob_return_defer(FAILED);
+		}
+		nob_da_append(objects, build_graph_strdup(graph, bin_path));
+		dep_path = nob_temp_sprintf("%s%s.d", output_dir, src_name);
+		if (strchr(src_name, '/') != NULL && mkdir_parents(bin_path) == FAILED) nob_return_defer(FAILED);
+		build_snapshot_add(src_file_path);
+		build_snapshot_add_output(bin_path);
+		build_snapshot_add_depfile(dep_path);
+
+		// TODO: Add MSVC support/flags
+		nob_cc(&obj_cmd);
+		nob_cmd_append(&obj_cmd, "-c", src_file_path);
+		nob_cmd_append(&obj_cmd, "-o", bin_path);
+		nob_cmd_dependency_file(&obj_cmd, dep_path);
+		// TODO: msvc version
+		if (shared) nob_cmd_append(&obj_cmd, "-fpic");
+		if (debug) nob_cmd_append(&obj_cmd, "-g");
+		nob_cmd_append_cmd(&obj_cmd, item_cmd);
+		uint64_t fingerprint = build_fingerprint_cmd(&obj_cmd);
+
+		rebuild_is_needed = build_needs_rebuild_dependency_file(bin_path, src_file_path, dep_path);
+		if (rebuild_is_needed < 0) nob_return_defer(FAILED);
+		if (rebuild_is_needed == 0 && !force_rebuild && !build_db_changed(bin_path, fingerprint)) {
+			obj_cmd.count = 0;
+			nob_temp_rewind(temp_checkpoint);
+			continue;
+		}
+
+		size_t obj_job;
+#if defined(_MSC_VER)
+		// TODO: MSVC preprocess flags for the object cache
+		obj_job = build_graph_add_job(graph, bin_path, &obj_cmd);
+#else
+		// Forced objects must really compile, a cache hit would only copy the old one back
+		if (build_cache.enabled) obj_job = build_cache_add_compile_job(graph, bin_path, &obj_cmd, force_rebuild);
+		else obj_job = build_graph_add_job(graph, bin_path, &obj_cmd);
+#endif
+		build_job_set_output(graph, obj_job, bin_path, fingerprint);
+		build_graph_add_dependency(graph, *objects_job, obj_job);
+		if (pch_job != BUILD_JOB_NONE) build_graph_add_dependency(graph, obj_job, pch_job);
+		nob_temp_rewind(temp_checkpoint);
+	}
+
+defer:
+	nob_temp_rewind(temp_checkpoint);
+	nob_cmd_free(obj_cmd);
+	return result;
+}
+
+// Unity (jumbo) build - module's sources are compiled as a few translation units that #include them,
+// so shared headers are parsed once per chunk instead of once per file.
+struct BuildUnity {
+	size_t chunks;               // Translation units per module, 0 turns unity builds off
+};
+
+static struct BuildUnity build_unity = {0};
+
+static int build_unity__compare_names(const void *a, const void *b) {
+	return strcmp(*(const char**)a, *(const char**)b);
+}
+
+static bool build_unity__is_name_char(char c) {
+	return isalnum((unsigned char)c) || c == '_';
+}
+
+// Last identifier in line[0..end)
+static Nob_String_View build_unity__last_name(Nob_String_View line, size_t end) {
+	while (end > 0 && !build_unity__is_name_char(line.data[end - 1])) end -= 1;
+	size_t start = end;
+	while (start > 0 && build_unity__is_name_char(line.data[start - 1])) start -= 1;
+	return nob_sv_from_parts(line.data + start, end - start);
+}
+
+// Names a file defines at file scope that would clash with another file in the same TU:
+// `static` functions/variables, typedefs and struct/union/enum tags. Only lines starting at column 0 are looked at.
+// `macros` receives names of its #defines, chunk #undefs them after the file so they don't change later files.
+static void build_unity__file_scope_names(Nob_String_View content, Nob_File_Paths *names, Nob_File_Paths *macros) {
+	static const char *tags[] = {"struct ", "union ", "enum "};
+	bool in_typedef = false;
+	while (content.count > 0) {
+		Nob_String_View line = nob_sv_chop_by_delim(&content, '\n');
+		Nob_String_View directive = nob_sv_trim_left(line);
+		if (nob_sv_starts_with(directive, nob_sv_from_cstr("#"))) {
+			nob_sv_chop_left(&directive, 1);
+			directive = nob_sv_trim_left(directive);
+			if (!nob_sv_starts_with(directive, nob_sv_from_cstr("define "))) continue;
+			nob_sv_chop_left(&directive, 7);
+			directive = nob_sv_trim_left(directive);
+			size_t end = 0;
+			while (end < directive.count && build_unity__is_name_char(directive.data[end])) end += 1;
+			if (end > 0) nob_da_append(macros, nob_temp_sv_to_cstr(nob_sv_from_parts(directive.data, end)));
+			continue;
+		}
+
+		// Multi-line typedef is named after its closing brace: `} Name;`
+		if (in_typedef && nob_sv_starts_with(line, nob_sv_from_cstr("}"))) {
+			in_typedef = false;
+			size_t end = 0;
+			while (end < line.count && line.data[end] != ';') end += 1;
+			Nob_String_View name = build_unity__last_name(line, end);
+			if (name.count > 0) nob_da_append(names, nob_temp_sv_to_cstr(name));
+			continue;
+		}
+		if (nob_sv_starts_with(line, nob_sv_from_cstr("typedef "))) {
+			size_t end = 0;
+			while (end < line.count && line.data[end] != ';') end += 1;
+			if (end == line.count) {
+				in_typedef = true;
+				continue;
+			}
+			// Function pointer is named inside `(*Name)`
+			for (size_t i = 0; i + 1 < end; ++i) {
+				if (line.data[i] != '(' || line.data[i + 1] != '*') continue;
+				end = i + 2;
+				while (end < line.count && build_unity__is_name_char(line.data[end])) end += 1;
+				break;
+			}
+			Nob_String_View name = build_unity__last_name(line, end);
+			if (name.count > 0) nob_da_append(names, nob_temp_sv_to_cstr(name));
+			continue;
+		}
+
+		// Tag definition `struct Name {`, forward declarations are fine. Tags have their own namespace.
+		bool is_tag = false;
+		for (size_t t = 0; t < NOB_ARRAY_LEN(tags) && !is_tag; ++t) {
+			if (!nob_sv_starts_with(line, nob_sv_from_cstr(tags[t]))) continue;
+			size_t start = strlen(tags[t]);
+			size_t end = start;
+			while (end < line.count && build_unity__is_name_char(line.data[end])) end += 1;
+			size_t brace = end;
+			while (brace < line.count && isspace((unsigned char)line.data[brace])) brace += 1;
+			is_tag = true;
+			if (end == start || (brace < line.count && line.data[brace] != '{')) continue;
+			// Brace on the next line counts too, a declaration would end with ( or ;
+			Nob_String_View next = nob_sv_trim_left(content);
+			if (brace == line.count && (next.count == 0 || next.data[0] != '{')) continue;
+			nob_da_append(names, nob_temp_sprintf("%s"SV_Fmt, tags[t], (int)(end - start), line.data + start));
+		}
+		if (is_tag || !nob_sv_starts_with(line, nob_sv_from_cstr("static "))) continue;
+
+		// For statics it is the last identifier before ( = ; [
+		size_t end = 0;
+		while (end < line.count && strchr("(=;[", line.data[end]) == NULL) end += 1;
+		while (end > 0 && isspace((unsigned char)line.data[end - 1])) end -= 1;
+		size_t start = end;
+		while (start > 0 && build_unity__is_name_char(line.data[start - 1])) start -= 1;
+		if (end <= start) continue;
+		nob_da_append(names, nob_temp_sv_to_cstr(nob_sv_from_parts(line.data + start, end - start)));
+	}
+}
+
+// Write `<output_dir>unity_<k>.c` chunks including every file of `file_names` (sorted in place), each followed by #undef of its macros.
+// Chunk is rewritten only when its content changes, so its object stays up to date.
+// `collision` receives a name defined by two files, then nothing is written and per-file compile should be used.
+enum RESULT build_unity_sources(const char *source_dir, Nob_File_Paths *file_names, const char *output_dir, size_t chunks, Nob_File_Paths *unity_names, const char **collision) {
+	enum RESULT result = SUCCESS;
+	Nob_String_Builder sb = {0};
+	Nob_String_Builder existing = {0};
+	Nob_File_Paths names = {0};
+	Nob_File_Paths macros = {0};
+	size_t *sizes = NULL;
+	size_t *macros_end = NULL;
+	size_t *chunk_of = NULL;
+	size_t *chunk_sizes = NULL;
+	*collision = NULL;
+	if (chunks > file_names->count) chunks = file_names->count;
+	if (!nob_mkdir_if_not_exists(output_dir)) nob_return_defer(FAILED);
+
+	// Directory order is not stable, chunk content must be
+	qsort(file_names->items, file_names->count, sizeof(*file_names->items), build_unity__compare_names);
+	sizes = (size_t*)calloc(file_names->count, sizeof(*sizes));
+	chunk_of = (size_t*)calloc(file_names->count, sizeof(*chunk_of));
+	chunk_sizes = (size_t*)calloc(chunks, sizeof(*chunk_sizes));
+	macros_end = (size_t*)calloc(file_names->count, sizeof(*macros_end));
+	NOB_ASSERT(sizes != NULL && chunk_of != NULL && chunk_sizes != NULL && macros_end != NULL && "Buy more RAM lol");
+
+	for (size_t i = 0; i < file_names->count; ++i) {
+		const char *path = nob_temp_sprintf("%s%s", source_dir, file_names->items[i]);
+		sb.count = 0;
+		if (!nob_read_entire_file(path, &sb)) nob_return_defer(FAILED);
+		sizes[i] = sb.count;
+		size_t names_start = names.count;
+		build_unity__file_scope_names(nob_sv_from_parts(sb.items, sb.count), &names, &macros);
+		macros_end[i] = macros.count;
+		for (size_t j = names_start; j < names.count; ++j) {
+			for (size_t k = 0; k < names_start; ++k) {
+				if (strcmp(names.items[j], names.items[k]) != 0) continue;
+				*collision = names.items[j];
+				nob_return_defer(SUCCESS);
+			}
+		}
+		// Same name repeated inside one file (declaration + definition) is fine
+		size_t unique_end = names_start;
+		for (size_t j = names_start; j < names.count; ++j) {
+			bool seen = false;
+			for (size_t k = names_start; k < unique_end; ++k) {
+				if (strcmp(names.items[j], names.items[k]) == 0) seen = true;
+			}
+			if (!seen) names.items[unique_end++] = names.items[j];
+		}
+		names.count = unique_end;
+	}
+
+	// Biggest files first into the lightest chunk keeps chunks about the same size
+	for (size_t assigned = 0; assigned < file_names->count; ++assigned) {
+		size_t biggest = 0;
+		for (size_t i = 0; i < file_names->count; ++i) {
+			if (sizes[i] != (size_t)-1 && (sizes[biggest] == (size_t)-1 || sizes[i] > sizes[biggest])) biggest = i;
+		}
+		size_t lightest = 0;
+		for (size_t k = 1; k < chunks; ++k) {
+			if (chunk_sizes[k] < chunk_sizes[lightest]) lightest = k;
+		}
+		chunk_of[biggest] = lightest;
+		chunk_sizes[lightest] += sizes[biggest];
+		sizes[biggest] = (size_t)-1;
+	}
+
+	// Chunks live in output_dir, sources are included relative to it
+	Nob_String_Builder to_root = {0};
+	for (const char *it = output_dir; *it != '\0'; ++it) {
+		if (*it == '/' || *it == '\\') nob_sb_append_cstr(&to_root, "../");
+	}
+	nob_sb_append_null(&to_root);
+
+	for (size_t k = 0; k < chunks; ++k) {
+		sb.count = 0;
+		nob_sb_appendf(&sb, "// Generated by nob for unity build, don't edit\n");
+		for (size_t i = 0; i < file_names->count; ++i) {
+			if (chunk_of[i] != k) continue;
+			nob_sb_appendf(&sb, "#include \"%s%s%s\"\n", to_root.items, source_dir, file_names->items[i]);
+			for (size_t j = i > 0 ? macros_end[i - 1] : 0; j < macros_end[i]; ++j) {
+				nob_sb_appendf(&sb, "#undef %s\n", macros.items[j]);
+			}
+		}
+		const char *unity_name = nob_temp_sprintf("unity_%zu.c", k);
+		const char *unity_path = nob_temp_sprintf("%s%s", output_dir, unity_name);
+		nob_da_append(unity_names, unity_name);
+		build_snapshot_add_output(unity_path);
+		existing.count = 0;
+		if (nob_file_exists(unity_path) == 1 && nob_read_entire_file(unity_path, &existing) &&
+			existing.count == sb.count && memcmp(existing.items, sb.items, sb.count) == 0) continue;
+		if (!nob_write_entire_file(unity_path, sb.items, sb.count)) {
+			nob_sb_free(to_root);
+			nob_return_defer(FAILED);
+		}
+	}
+	nob_sb_free(to_root);
+
+defer:
+	free(sizes);
+	free(chunk_of);
+	free(chunk_sizes);
+	free(macros_end);
+	nob_sb_free(sb);
+	nob_sb_free(existing);
+	nob_da_free(names);
+	nob_da_free(macros);
+	return result;
+}
+
+// Queue object jobs for stale files of a source tree that `globs` select, see nob_cmd_process_source_files().
+// Objects mirror the tree inside output_dir. With build_unity on, the tree compiles as unity chunks instead.
+enum RESULT nob_cmd_process_source_tree(struct BuildGraph *graph, Nob_Cmd *item_cmd, const char *source_dir, struct SourceGlobs globs, const char *output_dir, const char *src_extension, bool debug, bool shared, bool force_rebuild, Nob_File_Paths *objects, size_t *objects_job) {
+	enum RESULT result = SUCCESS;
+	Nob_File_Paths file_list = {0};
+	Nob_File_Paths dir_list = {0};
+	Nob_File_Paths unity_list = {0};
+	size_t temp_checkpoint = nob_temp_save();
+
+	if (nob_fetch_files_recursive(source_dir, &file_list, &dir_list, globs) == FAILED) {
+		nob_log(NOB_ERROR, "Failed to list sources of %s", source_dir);
+		assert(false);
+		nob_return_defer(FAILED);
+	}
+	// Added or removed files change their directory
+	for (size_t i = 0; i < dir_list.count; ++i) {
+		build_snapshot_add(nob_temp_sprintf("%s%s", source_dir, dir_list.items[i]));
+	}
+
+	if (build_unity.chunks > 0 && file_list.count > 1) {
+		const char *collision = NULL;
+		if (build_unity_sources(source_dir, &file_list, output_dir, build_unity.chunks, &unity_list, &collision) == FAILED) {
+			nob_log(NOB_ERROR, "Failed to write unity sources for %s", source_dir);
+			assert(false);
+			nob_return_defer(FAILED);
+		}
+		if (collision == NULL) {
+			result = nob_cmd_process_source_files(
+				graph, item_cmd, output_dir, &unity_list, output_dir, ".c",
+				debug, shared, force_rebuild, objects, objects_job);
+			nob_return_defer(result);
+		}
+		nob_log(NOB_INFO, "%s defines `%s` in more than one file, compiling it file by file", source_dir, collision);
+	}
+
+	result = nob_cmd_process_source_files(
+		graph, item_cmd, source_dir, &file_list, output_dir, src_extension,
+		debug, shared, force_rebuild, objects, objects_job);
+
+defer:
+	nob_temp_rewind(temp_checkpoint);
+	nob_da_free(file_list);
+	nob_da_free(dir_list);
+	nob_da_free(unity_list);
+	return result;
+}
+
+// Append object paths as command inputs
+void nob_cmd_input_files(Nob_Cmd *cmd, Nob_File_Paths *files) {
+	for (size_t i = 0; i < files->count; ++i) {
+		nob_cc_inputs(cmd, files->items[i]);
+	}
+}
+
+// Every `src_extension` file of a directory and its subdirectories, see nob_cmd_process_source_tree()
+enum RESULT nob_cmd_process_source_dir(struct BuildGraph *graph, Nob_Cmd *item_cmd, const char *source_dir, const char *output_dir, const char *src_extension, bool debug, bool shared, bool force_rebuild, Nob_File_Paths *objects, size_t *objects_job) {
+	size_t temp_checkpoint = nob_temp_save();
+	const char *include[] = {nob_temp_sprintf("**/*%s", src_extension)};
+	struct SourceGlobs globs = {include, NOB_ARRAY_LEN(include), NULL, 0};
+	enum RESULT result = nob_cmd_process_source_tree(
+		graph, item_cmd, source_dir, globs, output_dir, src_extension,
+		debug, shared, force_rebuild, objects, objects_job);
+	nob_temp_rewind(temp_checkpoint);
+	return result;
+}
+
+#endif // NOB_BUILD_H
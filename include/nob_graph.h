@@ -0,0 +1,505 @@
+#ifndef NOB_GRAPH_H
+#define NOB_GRAPH_H
+
+#ifdef NOB_IMPLEMENTATION
+    #undef NOB_IMPLEMENTATION
+    #include "nob.h"
+    #define NOB_IMPLEMENTATION
+#else
+    #include "nob.h"
+#endif
+#include "nob_utils.h"
+
+#if !defined(_WIN32)
+#	include <poll.h>
+#endif
+
+// Build graph - every command of the project (object, archive, link) is a job.
+// Edges are "must finish before" relations, so one scheduler can keep all process
+// slots busy across modules and wait only where something really depends on it.
+
+// Use as "no job" for optional dependencies
+#define BUILD_JOB_NONE ((size_t)-1)
+
+enum BUILD_JOB_STATE {
+	BUILD_JOB_PENDING,
+	BUILD_JOB_RUNNING,
+	BUILD_JOB_DONE,
+	BUILD_JOB_FAILED,
+};
+
+struct BuildJobIds {
+	size_t *items;
+	size_t count;
+	size_t capacity;
+};
+
+enum BUILD_STEP {
+	BUILD_STEP_DONE,    // Job is finished
+	BUILD_STEP_AGAIN,   // Hook replaced job's command, run it again
+	BUILD_STEP_FAILED,
+};
+
+struct BuildGraph;
+// Runs inside nob after job's command succeeded (right away for jobs without command)
+typedef enum BUILD_STEP (*BuildJobHook)(struct BuildGraph *graph, size_t job_id);
+// Asked when job is ready and none of its dependencies ran, true skips the job
+typedef bool (*BuildJobCheck)(struct BuildGraph *graph, size_t job_id);
+
+struct BuildJob {
+	const char *name;               // Shown in logs
+	Nob_Cmd cmd;                    // Empty command only groups its dependencies
+	struct BuildJobIds deps;        // Jobs that must finish first
+	struct BuildJobIds dependents;  // Filled when the graph starts running
+	enum BUILD_JOB_STATE state;
+	size_t waiting_count;           // Unfinished dependencies
+	size_t priority;                // Longest chain of jobs waiting on this one
+	BuildJobHook on_done;           // Optional
+	void *data;                     // Hook's data, graph owned (see build_graph_alloc())
+	BuildJobCheck up_to_date;       // Optional
+	BuildJobCheck before_start;     // Optional, runs right before the command, false fails the job
+	bool ran;                       // Command ran, or for group jobs any dependency did
+	const char *output;             // Artifact the job produces, NULL for none. Not used by the scheduler.
+	uint64_t fingerprint;           // Hash of the command producing `output`
+	Nob_File_Paths inputs;          // Files `output` is made from, graph owned strings
+};
+
+// One spawned process of a job, jobs with hooks can spawn more than one
+struct BuildSpan {
+	size_t job;
+	size_t lane;                    // Process slot it ran in, from 0
+	uint64_t start_ns;              // nob_nanos_since_unspecified_epoch()
+	uint64_t end_ns;
+};
+
+struct BuildSpans {
+	struct BuildSpan *items;
+	size_t count;
+	size_t capacity;
+};
+
+struct BuildGraph {
+	struct BuildJob *items;
+	size_t count;
+	size_t capacity;
+	Nob_File_Paths allocations;     // Owned strings and hook data jobs point to
+	struct BuildSpans spans;        // Filled by build_graph_run()
+	size_t slots;                   // Process slots of the last run
+	uint64_t start_ns;              // Last run
+	uint64_t end_ns;
+};
+
+// Zeroed memory that lives until build_graph_free()
+void *build_graph_alloc(struct BuildGraph *graph, size_t size) {
+	void *memory = calloc(1, size);
+	NOB_ASSERT(memory != NULL && "Buy more RAM lol");
+	nob_da_append(&graph->allocations, (const char*)memory);
+	return memory;
+}
+
+// Copy string into graph owned storage, lives until build_graph_free()
+const char *build_graph_strdup(struct BuildGraph *graph, const char *cstr) {
+	size_t size = strlen(cstr) + 1;
+	char *copy = (char*)build_graph_alloc(graph, size);
+	memcpy(copy, cstr, size);
+	return copy;
+}
+
+// Add job running `cmd` (NULL for group job). Arguments are copied and cmd is reset like nob_cmd_run() does.
+size_t build_graph_add_job(struct BuildGraph *graph, const char *name, Nob_Cmd *cmd) {
+	struct BuildJob job = {0};
+	job.name = build_graph_strdup(graph, name);
+	if (cmd != NULL) {
+		for (size_t i = 0; i < cmd->count; ++i) {
+			nob_cmd_append(&job.cmd, build_graph_strdup(graph, cmd->items[i]));
+		}
+		cmd->count = 0;
+	}
+	nob_da_append(graph, job);
+	return graph->count - 1;
+}
+
+void build_graph_add_dependency(struct BuildGraph *graph, size_t job_id, size_t dependency_id) {
+	if (job_id == BUILD_JOB_NONE || dependency_id == BUILD_JOB_NONE) return;
+	assert(job_id < graph->count && dependency_id < graph->count);
+	nob_da_append(&graph->items[job_id].deps, dependency_id);
+}
+
+void build_graph_add_dependencies(struct BuildGraph *graph, size_t job_id, struct BuildJobIds *dependency_ids) {
+	for (size_t i = 0; i < dependency_ids->count; ++i) {
+		build_graph_add_dependency(graph, job_id, dependency_ids->items[i]);
+	}
+}
+
+void build_graph_free(struct BuildGraph *graph) {
+	for (size_t i = 0; i < graph->count; ++i) {
+		nob_cmd_free(graph->items[i].cmd);
+		nob_da_free(graph->items[i].deps);
+		nob_da_free(graph->items[i].dependents);
+		nob_da_free(graph->items[i].inputs);
+	}
+	for (size_t i = 0; i < graph->allocations.count; ++i) {
+		free((void*)graph->allocations.items[i]);
+	}
+	nob_da_free(graph->allocations);
+	nob_da_free(graph->spans);
+	nob_da_free(*graph);
+	memset(graph, 0, sizeof(*graph));
+}
+
+static size_t build_graph__priority(struct BuildGraph *graph, size_t job_id, bool *visited) {
+	struct BuildJob *job = &graph->items[job_id];
+	if (visited[job_id]) return job->priority;
+	visited[job_id] = true;
+	size_t longest = 0;
+	for (size_t i = 0; i < job->dependents.count; ++i) {
+		size_t chain = build_graph__priority(graph, job->dependents.items[i], visited);
+		if (chain > longest) longest = chain;
+	}
+	job->priority = longest + 1;
+	return job->priority;
+}
+
+// Ready jobs are kept as max-heap on priority, so the longest chains start first
+static void build_graph__ready_push(struct BuildGraph *graph, struct BuildJobIds *ready, size_t job_id) {
+	nob_da_append(ready, job_id);
+	size_t i = ready->count - 1;
+	while (i > 0) {
+		size_t parent = (i - 1) / 2;
+		if (graph->items[ready->items[parent]].priority >= graph->items[ready->items[i]].priority) break;
+		nob_swap(size_t, ready->items[parent], ready->items[i]);
+		i = parent;
+	}
+}
+
+static size_t build_graph__ready_pop(struct BuildGraph *graph, struct BuildJobIds *ready) {
+	size_t top = ready->items[0];
+	ready->items[0] = ready->items[--ready->count];
+	size_t i = 0;
+	for (;;) {
+		size_t left = i * 2 + 1;
+		size_t right = left + 1;
+		size_t largest = i;
+		if (left < ready->count && graph->items[ready->items[left]].priority > graph->items[ready->items[largest]].priority) largest = left;
+		if (right < ready->count && graph->items[ready->items[right]].priority > graph->items[ready->items[largest]].priority) largest = right;
+		if (largest == i) break;
+		nob_swap(size_t, ready->items[largest], ready->items[i]);
+		i = largest;
+	}
+	return top;
+}
+
+static void build_graph__release_dependents(struct BuildGraph *graph, struct BuildJobIds *ready, size_t job_id) {
+	struct BuildJob *job = &graph->items[job_id];
+	job->state = BUILD_JOB_DONE;
+	for (size_t i = 0; i < job->dependents.count; ++i) {
+		struct BuildJob *dependent = &graph->items[job->dependents.items[i]];
+		assert(dependent->waiting_count > 0);
+		dependent->waiting_count -= 1;
+		if (dependent->waiting_count == 0) build_graph__ready_push(graph, ready, job->dependents.items[i]);
+	}
+}
+
+static bool build_graph__dependency_ran(struct BuildGraph *graph, struct BuildJob *job) {
+	for (size_t i = 0; i < job->deps.count; ++i) {
+		if (graph->items[job->deps.items[i]].ran) return true;
+	}
+	return false;
+}
+
+// Let job's hook decide if it is done. Returns false on failure.
+static bool build_graph__finish_job(struct BuildGraph *graph, struct BuildJobIds *ready, size_t job_id, size_t *finished_count) {
+	struct BuildJob *job = &graph->items[job_id];
+	enum BUILD_STEP step = job->on_done != NULL ? job->on_done(graph, job_id) : BUILD_STEP_DONE;
+	switch (step) {
+		case BUILD_STEP_DONE:
+			build_graph__release_dependents(graph, ready, job_id);
+			*finished_count += 1;
+			return true;
+		case BUILD_STEP_AGAIN:
+			job->state = BUILD_JOB_PENDING;
+			build_graph__ready_push(graph, ready, job_id);
+			return true;
+		case BUILD_STEP_FAILED:
+			nob_log(NOB_ERROR, "Job failed: %s", job->name);
+			job->state = BUILD_JOB_FAILED;
+			*finished_count += 1;
+			return false;
+	}
+	return false;
+}
+
+// GNU make jobserver - https://www.gnu.org/software/make/manual/html_node/Job-Slots.html
+// Started by make (or anything else passing `--jobserver-auth` in MAKEFLAGS) nob takes tokens from that pool.
+// Otherwise nob creates the pool and exports it to its children, so make-aware tools they run share it.
+// Every process owns one implicit token, nob reads one more byte for each extra job it runs at once.
+struct Jobserver {
+	bool active;
+	bool is_server;
+	int read_fd;                 // Non-blocking, private to nob
+	int write_fd;
+	size_t held;                 // Tokens read and not written back yet
+	struct { char *items; size_t count; size_t capacity; } tokens; // Bytes to give back, make uses them as job markers
+};
+
+static struct Jobserver jobserver = {0};
+
+#if !defined(_WIN32)
+// Shared pipe can't be switched to non-blocking, other processes reading it would see that too.
+// On Linux reopening it through /proc gives nob its own open file, elsewhere poll() + read() has a small race.
+static int jobserver__open_read(int fd) {
+#if defined(LINUX)
+	char path[64];
+	snprintf(path, sizeof(path), "/proc/self/fd/%d", fd);
+	int own_fd = open(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+	if (own_fd >= 0) return own_fd;
+#endif
+	return fd;
+}
+#endif
+
+// Join jobserver from MAKEFLAGS or create one with `max_procs` slots (0 means nob_nprocs())
+enum RESULT jobserver_init(size_t max_procs) {
+	enum RESULT result = SUCCESS;
+#if defined(_WIN32)
+	// TODO: make on Windows uses named semaphore `--jobserver-auth=gmake_semaphore_<n>`
+	NOB_UNUSED(max_procs);
+#else
+	size_t temp_checkpoint = nob_temp_save();
+	if (jobserver.active) nob_return_defer(SUCCESS);
+	if (max_procs == 0) max_procs = (size_t)nob_nprocs();
+
+	const char *makeflags = getenv("MAKEFLAGS");
+	const char *auth = NULL;
+	if (makeflags != NULL) {
+		// Last one wins, older make calls it --jobserver-fds
+		for (const char *it = makeflags; (it = strstr(it, "--jobserver-")) != NULL; it += 1) {
+			if (strncmp(it, "--jobserver-auth=", 17) == 0) auth = it + 17;
+			else if (strncmp(it, "--jobserver-fds=", 16) == 0) auth = it + 16;
+		}
+	}
+
+	if (auth != NULL) {
+		Nob_String_View value = nob_sv_from_parts(auth, strcspn(auth, " "));
+		if (nob_sv_starts_with(value, nob_sv_from_cstr("fifo:"))) {
+			value.data += 5;
+			value.count -= 5;
+			const char *fifo_path = nob_temp_sv_to_cstr(value);
+			jobserver.read_fd = open(fifo_path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+			jobserver.write_fd = open(fifo_path, O_WRONLY | O_CLOEXEC);
+			if (jobserver.read_fd < 0 || jobserver.write_fd < 0) {
+				nob_log(NOB_WARNING, "Jobserver fifo %s can't be opened, running without it: %s", fifo_path, strerror(errno));
+				nob_return_defer(SUCCESS);
+			}
+		}
+		else {
+			int read_fd = -1;
+			int write_fd = -1;
+			// Make doesn't pass the pipe to commands it doesn't consider recursive (no `+` prefix)
+			if (sscanf(nob_temp_sv_to_cstr(value), "%d,%d", &read_fd, &write_fd) != 2 || read_fd < 0 || write_fd < 0 ||
+				fcntl(read_fd, F_GETFD) < 0 || fcntl(write_fd, F_GETFD) < 0) {
+				nob_log(NOB_WARNING, "Jobserver from MAKEFLAGS is not reachable, running without it. Prefix nob's recipe with `+`.");
+				nob_return_defer(SUCCESS);
+			}
+			jobserver.read_fd = jobserver__open_read(read_fd);
+			jobserver.write_fd = write_fd;
+		}
+		jobserver.active = true;
+		nob_log(NOB_INFO, "Using jobserver from MAKEFLAGS");
+		nob_return_defer(SUCCESS);
+	}
+
+	int fds[2];
+	if (pipe(fds) < 0) {
+		nob_log(NOB_ERROR, "Could not create jobserver pipe: %s", strerror(errno));
+		assert(false);
+		nob_return_defer(FAILED);
+	}
+	for (size_t i = 1; i < max_procs; ++i) {
+		if (write(fds[1], "+", 1) != 1) {
+			nob_log(NOB_ERROR, "Could not fill jobserver pipe: %s", strerror(errno));
+			assert(false);
+			nob_return_defer(FAILED);
+		}
+	}
+	jobserver.read_fd = jobserver__open_read(fds[0]);
+	jobserver.write_fd = fds[1];
+	jobserver.is_server = true;
+	jobserver.active = true;
+	setenv("MAKEFLAGS", nob_temp_sprintf("-j%zu --jobserver-auth=%d,%d", max_procs, fds[0], fds[1]), 1);
+
+defer:
+	nob_temp_rewind(temp_checkpoint);
+#endif
+	return result;
+}
+
+// Take one token without blocking
+bool jobserver_try_acquire(void) {
+#if defined(_WIN32)
+	return false;
+#else
+	if (!jobserver.active) return false;
+	struct pollfd pfd = { .fd = jobserver.read_fd, .events = POLLIN };
+	if (poll(&pfd, 1, 0) <= 0) return false;
+	char token;
+	ssize_t n = read(jobserver.read_fd, &token, 1);
+	if (n != 1) return false;
+	nob_da_append(&jobserver.tokens, token);
+	jobserver.held += 1;
+	return true;
+#endif
+}
+
+void jobserver_release(void) {
+#if !defined(_WIN32)
+	if (!jobserver.active || jobserver.held == 0) return;
+	char token = jobserver.tokens.items[--jobserver.tokens.count];
+	while (write(jobserver.write_fd, &token, 1) < 0 && errno == EINTR) {}
+	jobserver.held -= 1;
+#endif
+}
+
+// Run every job of the graph using up to `max_procs` processes at once (0 means nob_nprocs(), or no limit besides jobserver from MAKEFLAGS).
+// Stops starting new jobs after the first failure, but waits for already running ones.
+enum RESULT build_graph_run(struct BuildGraph *graph, size_t max_procs) {
+	enum RESULT result = SUCCESS;
+	struct BuildJobIds ready = {0};
+	struct BuildJobIds running_jobs = {0};
+	struct BuildJobIds running_spans = {0};  // Index into graph->spans for each running job
+	Nob_Procs running_procs = {0};
+	Nob_Procs started = {0};
+	bool *visited = NULL;
+	bool failed = false;
+	size_t finished_count = 0;
+	// Outer jobserver already decides how many jobs fit
+	if (max_procs == 0) max_procs = jobserver.active && !jobserver.is_server ? SIZE_MAX : (size_t)nob_nprocs();
+	graph->spans.count = 0;
+	graph->slots = 0;
+	graph->start_ns = nob_nanos_since_unspecified_epoch();
+
+	for (size_t i = 0; i < graph->count; ++i) {
+		struct BuildJob *job = &graph->items[i];
+		job->state = BUILD_JOB_PENDING;
+		job->ran = false;
+		job->dependents.count = 0;
+		job->waiting_count = job->deps.count;
+	}
+	for (size_t i = 0; i < graph->count; ++i) {
+		struct BuildJob *job = &graph->items[i];
+		for (size_t j = 0; j < job->deps.count; ++j) {
+			nob_da_append(&graph->items[job->deps.items[j]].dependents, i);
+		}
+	}
+
+	visited = (bool*)calloc(graph->count + 1, sizeof(bool));
+	NOB_ASSERT(visited != NULL && "Buy more RAM lol");
+	for (size_t i = 0; i < graph->count; ++i) {
+		build_graph__priority(graph, i, visited);
+	}
+	for (size_t i = 0; i < graph->count; ++i) {
+		if (graph->items[i].waiting_count == 0) build_graph__ready_push(graph, &ready, i);
+	}
+
+	for (;;) {
+		while (!failed && ready.count > 0 && running_jobs.count < max_procs) {
+			// First job runs on nob's implicit token, others need one from the jobserver
+			struct BuildJob *next = &graph->items[ready.items[0]];
+			bool next_spawns = next->cmd.count > 0;
+			if (next_spawns && jobserver.active && running_jobs.count > 0 && jobserver.held < running_jobs.count) {
+				if (!jobserver_try_acquire()) break;
+			}
+			size_t job_id = build_graph__ready_pop(graph, &ready);
+			struct BuildJob *job = &graph->items[job_id];
+			bool dependency_ran = build_graph__dependency_ran(graph, job);
+			if (job->up_to_date != NULL && !dependency_ran && job->up_to_date(graph, job_id)) {
+				build_graph__release_dependents(graph, &ready, job_id);
+				finished_count += 1;
+				continue;
+			}
+			if (job->cmd.count == 0) {
+				job->ran = job->ran || dependency_ran;
+				if (!build_graph__finish_job(graph, &ready, job_id, &finished_count)) failed = true;
+				continue;
+			}
+			job->ran = true;
+			if (job->before_start != NULL && !job->before_start(graph, job_id)) {
+				nob_log(NOB_ERROR, "Failed to prepare job: %s", job->name);
+				job->state = BUILD_JOB_FAILED;
+				failed = true;
+				break;
+			}
+			job->state = BUILD_JOB_RUNNING;
+			if (!nob_cmd_run(&job->cmd, .async = &started, .dont_reset = true)) {
+				nob_log(NOB_ERROR, "Failed to start job: %s", job->name);
+				job->state = BUILD_JOB_FAILED;
+				failed = true;
+				break;
+			}
+			// Lowest slot no running job occupies
+			size_t lane = 0;
+			for (bool taken = true; taken; ) {
+				taken = false;
+				for (size_t i = 0; i < running_spans.count; ++i) {
+					if (graph->spans.items[running_spans.items[i]].lane == lane) taken = true;
+				}
+				if (taken) lane += 1;
+			}
+			if (lane + 1 > graph->slots) graph->slots = lane + 1;
+			struct BuildSpan span = {job_id, lane, nob_nanos_since_unspecified_epoch(), 0};
+			nob_da_append(&running_spans, graph->spans.count);
+			nob_da_append(&graph->spans, span);
+			nob_da_append(&running_procs, started.items[0]);
+			nob_da_append(&running_jobs, job_id);
+			started.count = 0;
+		}
+		if (running_jobs.count == 0) break;
+
+		// Sleep until any running process exits
+		size_t index = 0;
+		int ret = nob_procs_wait_any(running_procs, &index);
+		if (ret < 0) {
+			failed = true;
+			nob_procs_flush(&running_procs);
+			running_jobs.count = 0;
+			break;
+		}
+		size_t job_id = running_jobs.items[index];
+		graph->spans.items[running_spans.items[index]].end_ns = nob_nanos_since_unspecified_epoch();
+		nob_da_remove_unordered(&running_procs, index);
+		nob_da_remove_unordered(&running_jobs, index);
+		nob_da_remove_unordered(&running_spans, index);
+		// Keep one token per running job except the first, others go back to the pool
+		while (jobserver.held > 0 && jobserver.held + 1 > running_jobs.count) jobserver_release();
+		if (ret == 0) {
+			nob_log(NOB_ERROR, "Job failed: %s", graph->items[job_id].name);
+			graph->items[job_id].state = BUILD_JOB_FAILED;
+			finished_count += 1;
+			failed = true;
+			continue;
+		}
+		if (!build_graph__finish_job(graph, &ready, job_id, &finished_count)) failed = true;
+	}
+
+	if (failed) nob_return_defer(FAILED);
+	if (finished_count != graph->count) {
+		nob_log(NOB_ERROR, "Build graph has a dependency cycle, %zu of %zu jobs were never ready", graph->count - finished_count, graph->count);
+		assert(false);
+		nob_return_defer(FAILED);
+	}
+
+defer:
+	graph->end_ns = nob_nanos_since_unspecified_epoch();
+	// Slots a jobserver would have allowed aren't known, the ones used count
+	if (max_procs != SIZE_MAX && max_procs > graph->slots) graph->slots = max_procs;
+	while (jobserver.held > 0) jobserver_release();
+	free(visited);
+	nob_da_free(ready);
+	nob_da_free(running_jobs);
+	nob_da_free(running_spans);
+	nob_da_free(running_procs);
+	nob_da_free(started);
+	return result;
+}
+
+#endif // NOB_GRAPH_H
@@ -0,0 +1,232 @@
+#ifndef NOB_TRACE_H
+#define NOB_TRACE_H
+
+#ifdef NOB_IMPLEMENTATION
+    #undef NOB_IMPLEMENTATION
+    #include "nob.h"
+    #define NOB_IMPLEMENTATION
+#else
+    #include "nob.h"
+#endif
+#include "nob_utils.h"
+#include "nob_graph.h"
+
+// Build timeline - nob's own phases (downloads, extraction, planning) run on lane 0,
+// every spawned command on the lane of the process slot it used. Written in Chrome trace
+// format, opens in https://ui.perfetto.dev or chrome://tracing.
+
+struct TraceEvent {
+	const char *name;               // Owned
+	const char *category;           // "phase" or "job"
+	size_t lane;
+	uint64_t start_ns;              // nob_nanos_since_unspecified_epoch()
+	uint64_t end_ns;
+};
+
+struct TraceEvents {
+	struct TraceEvent *items;
+	size_t count;
+	size_t capacity;
+};
+
+struct Trace {
+	uint64_t start_ns;
+	struct TraceEvents events;
+	struct TraceEvents jobs;        // Summed duration of each job's commands, for the slowest ones
+	Nob_File_Paths critical_path;   // Owned names, sequential graph runs add up
+	uint64_t critical_ns;
+	uint64_t slot_ns;               // Process slots times graph run time
+	uint64_t busy_ns;               // Of them spent running commands
+	size_t lanes;
+};
+
+static struct Trace build_trace = {0};
+
+static const char *trace__strdup(const char *cstr) {
+	size_t size = strlen(cstr) + 1;
+	char *copy = (char*)malloc(size);
+	NOB_ASSERT(copy != NULL && "Buy more RAM lol");
+	memcpy(copy, cstr, size);
+	return copy;
+}
+
+void trace_start(void) {
+	build_trace.start_ns = nob_nanos_since_unspecified_epoch();
+}
+
+// Returns id for trace_phase_end()
+size_t trace_phase_begin(const char *name) {
+	uint64_t now = nob_nanos_since_unspecified_epoch();
+	struct TraceEvent event = {trace__strdup(name), "phase", 0, now, now};
+	nob_da_append(&build_trace.events, event);
+	return build_trace.events.count - 1;
+}
+
+void trace_phase_end(size_t phase) {
+	build_trace.events.items[phase].end_ns = nob_nanos_since_unspecified_epoch();
+}
+
+// Latest finish of the job or anything it waits on
+static uint64_t trace__job_end(struct BuildGraph *graph, size_t job_id, uint64_t *own_end, uint64_t *chain_end) {
+	if (chain_end[job_id] != 0) return chain_end[job_id];
+	uint64_t end = own_end[job_id];
+	struct BuildJob *job = &graph->items[job_id];
+	for (size_t i = 0; i < job->deps.count; ++i) {
+		uint64_t dep_end = trace__job_end(graph, job->deps.items[i], own_end, chain_end);
+		if (dep_end > end) end = dep_end;
+	}
+	// 1 marks visited jobs that never ran
+	chain_end[job_id] = end > 0 ? end : 1;
+	return chain_end[job_id];
+}
+
+// Add commands of a finished build_graph_run() to the timeline and the summary
+void trace_add_graph(struct BuildGraph *graph) {
+	if (graph->count == 0 || graph->start_ns == 0) return;
+	uint64_t *own_start = (uint64_t*)calloc(graph->count, sizeof(uint64_t));
+	uint64_t *own_end = (uint64_t*)calloc(graph->count, sizeof(uint64_t));
+	uint64_t *chain_end = (uint64_t*)calloc(graph->count, sizeof(uint64_t));
+	uint64_t *duration = (uint64_t*)calloc(graph->count, sizeof(uint64_t));
+	NOB_ASSERT(own_start != NULL && own_end != NULL && chain_end != NULL && duration != NULL && "Buy more RAM lol");
+
+	// Lane 0 is nob itself
+	for (size_t i = 0; i < graph->spans.count; ++i) {
+		struct BuildSpan span = graph->spans.items[i];
+		// Interrupted runs don't get an end
+		if (span.end_ns == 0) span.end_ns = graph->end_ns;
+		struct TraceEvent event = {trace__strdup(graph->items[span.job].name), "job", span.lane + 1, span.start_ns, span.end_ns};
+		nob_da_append(&build_trace.events, event);
+		if (own_start[span.job] == 0 || span.start_ns < own_start[span.job]) own_start[span.job] = span.start_ns;
+		if (span.end_ns > own_end[span.job]) own_end[span.job] = span.end_ns;
+		duration[span.job] += span.end_ns - span.start_ns;
+		build_trace.busy_ns += span.end_ns - span.start_ns;
+	}
+	build_trace.slot_ns += graph->slots * (graph->end_ns - graph->start_ns);
+	if (graph->slots > build_trace.lanes) build_trace.lanes = graph->slots;
+	for (size_t i = 0; i < graph->count; ++i) {
+		if (duration[i] == 0) continue;
+		struct TraceEvent job = {trace__strdup(graph->items[i].name), "job", 0, own_start[i], own_start[i] + duration[i]};
+		nob_da_append(&build_trace.jobs, job);
+	}
+
+	// Critical path ends at the job finishing last and follows the dependency that finished last
+	size_t current = BUILD_JOB_NONE;
+	uint64_t latest = 1;
+	for (size_t i = 0; i < graph->count; ++i) {
+		uint64_t end = trace__job_end(graph, i, own_end, chain_end);
+		if (end > latest) {
+			latest = end;
+			current = i;
+		}
+	}
+	size_t path_start = build_trace.critical_path.count;
+	while (current != BUILD_JOB_NONE) {
+		if (duration[current] > 0) {
+			nob_da_append(&build_trace.critical_path, trace__strdup(graph->items[current].name));
+			build_trace.critical_ns += own_end[current] - own_start[current];
+		}
+		size_t next = BUILD_JOB_NONE;
+		latest = 1;
+		struct BuildJob *job = &graph->items[current];
+		for (size_t i = 0; i < job->deps.count; ++i) {
+			if (chain_end[job->deps.items[i]] > latest) {
+				latest = chain_end[job->deps.items[i]];
+				next = job->deps.items[i];
+			}
+		}
+		current = next;
+	}
+	// Walked from the end, stored from the start
+	for (size_t i = path_start, j = build_trace.critical_path.count; i + 1 < j; ++i, --j) {
+		const char *swap = build_trace.critical_path.items[i];
+		build_trace.critical_path.items[i] = build_trace.critical_path.items[j - 1];
+		build_trace.critical_path.items[j - 1] = swap;
+	}
+
+	free(own_start);
+	free(own_end);
+	free(chain_end);
+	free(duration);
+}
+
+static void trace__append_json_string(Nob_String_Builder *sb, const char *cstr) {
+	nob_da_append(sb, '"');
+	for (const char *it = cstr; *it != '\0'; ++it) {
+		if (*it == '"' || *it == '\\') nob_da_append(sb, '\\');
+		nob_da_append(sb, *it);
+	}
+	nob_da_append(sb, '"');
+}
+
+enum RESULT trace_write(const char *file_path) {
+	enum RESULT result = SUCCESS;
+	Nob_String_Builder sb = {0};
+	nob_sb_append_cstr(&sb, "{\"traceEvents\":[\n");
+	nob_sb_append_cstr(&sb, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"nob\"}}");
+	for (size_t lane = 1; lane <= build_trace.lanes; ++lane) {
+		nob_sb_appendf(&sb, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%zu,\"args\":{\"name\":\"slot %zu\"}}", lane, lane);
+	}
+	for (size_t i = 0; i < build_trace.events.count; ++i) {
+		struct TraceEvent *event = &build_trace.events.items[i];
+		nob_sb_append_cstr(&sb, ",\n{\"name\":");
+		trace__append_json_string(&sb, event->name);
+		// Microseconds since trace_start()
+		nob_sb_appendf(&sb, ",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%zu,\"ts\":%.3f,\"dur\":%.3f}",
+			event->category, event->lane,
+			(event->start_ns - build_trace.start_ns) / 1000.0, (event->end_ns - event->start_ns) / 1000.0);
+	}
+	nob_sb_append_cstr(&sb, "\n],\"displayTimeUnit\":\"ms\"}\n");
+	if (!nob_write_entire_file(file_path, sb.items, sb.count)) nob_return_defer(FAILED);
+
+defer:
+	nob_sb_free(sb);
+	return result;
+}
+
+static int trace__compare_duration(const void *a, const void *b) {
+	uint64_t duration_a = ((const struct TraceEvent*)a)->end_ns - ((const struct TraceEvent*)a)->start_ns;
+	uint64_t duration_b = ((const struct TraceEvent*)b)->end_ns - ((const struct TraceEvent*)b)->start_ns;
+	return duration_a < duration_b ? 1 : duration_a > duration_b ? -1 : 0;
+}
+
+// Total time, critical path, idle slots and the 10 slowest jobs
+void trace_report(void) {
+	if (build_trace.start_ns == 0) return;
+	double total = (nob_nanos_since_unspecified_epoch() - build_trace.start_ns) / 1e9;
+	nob_log(NOB_INFO, "Build time: %.2f s, temp storage peak %zu KiB", total, nob_temp_high_water() / 1024);
+	// Nothing was out of date
+	if (build_trace.busy_ns == 0) return;
+
+	Nob_String_Builder sb = {0};
+	for (size_t i = 0; i < build_trace.critical_path.count; ++i) {
+		if (i > 0) nob_sb_append_cstr(&sb, " -> ");
+		nob_sb_append_cstr(&sb, build_trace.critical_path.items[i]);
+	}
+	nob_sb_append_null(&sb);
+	nob_log(NOB_INFO, "Critical path: %.2f s over %zu jobs: %s", build_trace.critical_ns / 1e9, build_trace.critical_path.count, sb.items);
+	nob_sb_free(sb);
+
+	uint64_t idle_ns = build_trace.slot_ns - build_trace.busy_ns;
+	nob_log(NOB_INFO, "Idle process slots: %.0f%% (%.2f of %.2f slot seconds)",
+		100.0 * idle_ns / build_trace.slot_ns, idle_ns / 1e9, build_trace.slot_ns / 1e9);
+
+	if (build_trace.jobs.count == 0) return;
+	qsort(build_trace.jobs.items, build_trace.jobs.count, sizeof(*build_trace.jobs.items), trace__compare_duration);
+	nob_log(NOB_INFO, "Slowest jobs:");
+	for (size_t i = 0; i < build_trace.jobs.count && i < 10; ++i) {
+		struct TraceEvent *job = &build_trace.jobs.items[i];
+		nob_log(NOB_INFO, "  %6.2f s  %s", (job->end_ns - job->start_ns) / 1e9, job->name);
+	}
+}
+
+void trace_free(void) {
+	for (size_t i = 0; i < build_trace.events.count; ++i) free((void*)build_trace.events.items[i].name);
+	for (size_t i = 0; i < build_trace.jobs.count; ++i) free((void*)build_trace.jobs.items[i].name);
+	for (size_t i = 0; i < build_trace.critical_path.count; ++i) free((void*)build_trace.critical_path.items[i]);
+	nob_da_free(build_trace.events);
+	nob_da_free(build_trace.jobs);
+	nob_da_free(build_trace.critical_path);
+	memset(&build_trace, 0, sizeof(build_trace));
+}
+
+#endif // NOB_TRACE_H
@@ -30,6 +30,14 @@
 #	define nob_cc(cmd) nob_cmd_append(cmd, "cc")
 #endif
 
+#if !defined(_WIN32)
+#	include <pthread.h>
+#	include <sys/file.h>
+#else
+#	include <sys/stat.h>
+#	include <sys/utime.h>
+#endif
+
 enum RESULT {
 	SUCCESS,
 	FAILED,
@@ -54,6 +62,18 @@ enum OPTIMIZATION_OPTION {
 	OPTIMIZATION_AGGRESSIVE,  // -Oz
 };
 
+enum PGO_STAGE {
+	PGO_NONE,
+	PGO_GENERATE,             // -fprofile-generate, binary writes profile when it exits
+	PGO_USE,                  // -fprofile-use
+};
+
+enum CC_FAMILY {
+	CC_FAMILY_UNKNOWN,        // Not asked yet
+	CC_FAMILY_GCC,            // And anything else taking gcc's flags
+	CC_FAMILY_CLANG,
+};
+
 enum ERROR_OPTION {
     ERROR_OPTION_AS_ERRORS,    // Treat warnings as errors
     ERROR_OPTION_NONE,        // No warnings
@@ -79,6 +99,127 @@ void swap_dir_slashes(char *dir_path, int length) {
 	}
 }
 
+#if !defined(_WIN32)
+struct DeleteQueue {
+	pthread_mutex_t lock;
+	int root_fd;
+	Nob_File_Paths dirs;            // Subdirectories of the root, malloc'd
+	size_t next;
+	bool failed;
+};
+
+// Delete everything inside `dir_fd` and close it, one thread. Vanished entries are not errors,
+// something else may be deleting the same tree.
+static bool delete__tree_at(int dir_fd, const char *dir_name) {
+	DIR *dir = fdopendir(dir_fd);
+	if (dir == NULL) {
+		close(dir_fd);
+		return false;
+	}
+	bool ok = true;
+	struct dirent *entry;
+	while ((entry = readdir(dir)) != NULL) {
+		const char *name = entry->d_name;
+		if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) continue;
+		bool is_dir = entry->d_type == DT_DIR;
+		if (entry->d_type == DT_UNKNOWN) {
+			struct stat st;
+			is_dir = fstatat(dirfd(dir), name, &st, AT_SYMLINK_NOFOLLOW) == 0 && S_ISDIR(st.st_mode);
+		}
+		if (!is_dir) {
+			if (unlinkat(dirfd(dir), name, 0) == 0 || errno == ENOENT) continue;
+		}
+		else {
+			int child = openat(dirfd(dir), name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+			if (child < 0 && errno == ENOENT) continue;
+			if (child >= 0 && delete__tree_at(child, name) && (unlinkat(dirfd(dir), name, AT_REMOVEDIR) == 0 || errno == ENOENT)) continue;
+		}
+		nob_log(NOB_ERROR, "Could not delete %s/%s: %s", dir_name, name, strerror(errno));
+		ok = false;
+	}
+	closedir(dir);
+	return ok;
+}
+
+static void *delete__worker(void *arg) {
+	struct DeleteQueue *queue = (struct DeleteQueue*)arg;
+	for (;;) {
+		pthread_mutex_lock(&queue->lock);
+		const char *name = queue->next < queue->dirs.count ? queue->dirs.items[queue->next++] : NULL;
+		pthread_mutex_unlock(&queue->lock);
+		if (name == NULL) break;
+
+		int child = openat(queue->root_fd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+		bool ok = child < 0 ? errno == ENOENT : delete__tree_at(child, name) &&
+			(unlinkat(queue->root_fd, name, AT_REMOVEDIR) == 0 || errno == ENOENT);
+		if (ok) continue;
+		pthread_mutex_lock(&queue->lock);
+		queue->failed = true;
+		pthread_mutex_unlock(&queue->lock);
+	}
+	return NULL;
+}
+
+// Files of the root go right away, subdirectories are handed to the threads
+static bool delete__directory(const char *dir_path) {
+	struct DeleteQueue queue = {0};
+	queue.root_fd = open(dir_path, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+	if (queue.root_fd < 0) {
+		if (errno == ENOENT) return true;
+		// Same as rm -rf on a file or symlink
+		if (errno == ENOTDIR || errno == ELOOP) return unlink(dir_path) == 0;
+		nob_log(NOB_ERROR, "Could not open %s: %s", dir_path, strerror(errno));
+		return false;
+	}
+
+	int list_fd = dup(queue.root_fd);
+	DIR *dir = list_fd < 0 ? NULL : fdopendir(list_fd);
+	if (dir == NULL) {
+		if (list_fd >= 0) close(list_fd);
+		queue.failed = true;
+	}
+	struct dirent *entry;
+	while (dir != NULL && (entry = readdir(dir)) != NULL) {
+		const char *name = entry->d_name;
+		if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) continue;
+		bool is_dir = entry->d_type == DT_DIR;
+		if (entry->d_type == DT_UNKNOWN) {
+			struct stat st;
+			is_dir = fstatat(queue.root_fd, name, &st, AT_SYMLINK_NOFOLLOW) == 0 && S_ISDIR(st.st_mode);
+		}
+		if (is_dir) {
+			nob_da_append(&queue.dirs, strdup(name));
+		}
+		else if (unlinkat(queue.root_fd, name, 0) != 0 && errno != ENOENT) {
+			nob_log(NOB_ERROR, "Could not delete %s/%s: %s", dir_path, name, strerror(errno));
+			queue.failed = true;
+		}
+	}
+	if (dir != NULL) closedir(dir);
+
+	pthread_mutex_init(&queue.lock, NULL);
+	pthread_t threads[16];
+	size_t thread_count = (size_t)nob_nprocs();
+	if (thread_count > NOB_ARRAY_LEN(threads)) thread_count = NOB_ARRAY_LEN(threads);
+	if (thread_count > queue.dirs.count) thread_count = queue.dirs.count;
+	size_t started = 0;
+	for (size_t i = 1; i < thread_count; ++i) {
+		if (pthread_create(&threads[started], NULL, delete__worker, &queue) != 0) break;
+		started += 1;
+	}
+	delete__worker(&queue);
+	for (size_t i = 0; i < started; ++i) pthread_join(threads[i], NULL);
+	pthread_mutex_destroy(&queue.lock);
+	close(queue.root_fd);
+	for (size_t i = 0; i < queue.dirs.count; ++i) free((void*)queue.dirs.items[i]);
+	nob_da_free(queue.dirs);
+
+	return !queue.failed && (rmdir(dir_path) == 0 || errno == ENOENT);
+}
+#endif
+
+// Delete directory with everything in it, missing directory is not an error.
+// Subdirectories of `dir_path` are deleted on several threads.
 enum RESULT delete_directory(const char *dir_path) {
 	enum RESULT result = SUCCESS;
 	size_t temp_checkpoint = nob_temp_save();
@@ -86,16 +227,16 @@ enum RESULT delete_directory(const char *dir_path) {
 	char dir_buffer[1024] = {0};
 	snprintf(dir_buffer, sizeof(dir_buffer) / sizeof(dir_buffer[0]), "%s", dir_path);
 	swap_dir_slashes(dir_buffer, sizeof(dir_buffer) / sizeof(dir_buffer[0]));
+	// TODO: FindFirstFile/DeleteFile walk on Windows
 	// explicitly call from cmd.exe otherwise gives error
 	if (system(nob_temp_sprintf("cmd.exe /c \"rmdir /s /q %s \"", dir_buffer)) == FAILED) {
 		nob_log(NOB_ERROR, "Failed to delete a directory: %s", dir_path);
 		assert(false);
 		nob_return_defer(FAILED);
 	}
-#elif defined(LINUX)
-	Nob_Cmd rm_cmd = {0};
-	nob_cmd_append(&rm_cmd, "rm", "-rf", dir_path, "||", "true");
-	if (!nob_cmd_run(&rm_cmd)) {
+#else
+	nob_log(NOB_INFO, "deleting %s", dir_path);
+	if (!delete__directory(dir_path)) {
 		nob_log(NOB_ERROR, "Failed to delete a directory: %s", dir_path);
 		assert(false);
 		nob_return_defer(FAILED);
@@ -106,6 +247,100 @@ defer:
 	return result;
 }
 
+#if !defined(_WIN32)
+// Detached process keeps only `keep` and stdio pointed at /dev/null. Inherited pipes and sockets
+// (jobserver, daemon clients) would otherwise stay open until it finishes.
+static void delete__detach_fds(int keep) {
+	int null_fd = open("/dev/null", O_RDWR);
+	if (null_fd >= 0) {
+		dup2(null_fd, STDIN_FILENO);
+		dup2(null_fd, STDOUT_FILENO);
+		dup2(null_fd, STDERR_FILENO);
+		if (null_fd > STDERR_FILENO && null_fd != keep) close(null_fd);
+	}
+	// Open descriptors are listed there on Linux and macOS
+	DIR *dir = opendir("/dev/fd");
+	if (dir == NULL) {
+		long max_fd = sysconf(_SC_OPEN_MAX);
+		if (max_fd < 0 || max_fd > 65536) max_fd = 65536;
+		for (int fd = STDERR_FILENO + 1; fd < max_fd; ++fd) {
+			if (fd != keep) close(fd);
+		}
+		return;
+	}
+	struct dirent *entry;
+	while ((entry = readdir(dir)) != NULL) {
+		if (!isdigit((unsigned char)entry->d_name[0])) continue;
+		int fd = atoi(entry->d_name);
+		if (fd > STDERR_FILENO && fd != keep && fd != dirfd(dir)) close(fd);
+	}
+	closedir(dir);
+}
+
+// Entries of `trash_dir` nobody holds the lock of were left by killed runs
+static void delete__abandoned_trash(const char *trash_dir) {
+	DIR *dir = opendir(trash_dir);
+	if (dir == NULL) return;
+	struct dirent *entry;
+	while ((entry = readdir(dir)) != NULL) {
+		if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+		int entry_fd = openat(dirfd(dir), entry->d_name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+		if (entry_fd < 0) continue;
+		if (flock(entry_fd, LOCK_EX | LOCK_NB) == 0) {
+			const char *path = nob_temp_sprintf("%s/%s", trash_dir, entry->d_name);
+			delete__directory(path);
+		}
+		close(entry_fd);
+	}
+	closedir(dir);
+}
+#endif
+
+// Move `dir_path` into `trash_dir` and delete it in a detached process, so the build doesn't wait
+// for big trees. `trash_dir` must be on the same filesystem. Each moved directory stays locked
+// (flock) by the process deleting it, unlocked leftovers of killed runs are deleted along.
+enum RESULT delete_directory_background(const char *dir_path, const char *trash_dir) {
+	enum RESULT result = SUCCESS;
+	size_t temp_checkpoint = nob_temp_save();
+#if defined(_WIN32)
+	// TODO: detached delete on Windows
+	(void)trash_dir;
+	result = delete_directory(dir_path);
+#else
+	static size_t trash_count = 0;
+	int lock_fd = -1;
+	if (nob_file_exists(dir_path) != 1) nob_return_defer(SUCCESS);
+	const char *trash_path = nob_temp_sprintf("%s/%d-%zu", trash_dir, (int)getpid(), trash_count++);
+	// Locked before the move, so it's never seen unlocked in the trash
+	lock_fd = open(dir_path, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+	if (lock_fd < 0 || flock(lock_fd, LOCK_EX) != 0 ||
+		(mkdir(trash_dir, 0755) != 0 && errno != EEXIST) || rename(dir_path, trash_path) != 0) {
+		nob_return_defer(delete_directory(dir_path));
+	}
+
+	// Grandchild is adopted by init, nob never waits for it and graph's wait-any never sees it
+	fflush(NULL);
+	pid_t child = fork();
+	if (child == 0) {
+		if (fork() == 0) {
+			nob_minimal_log_level = NOB_NO_LOGS;
+			delete__detach_fds(lock_fd);
+			delete__directory(trash_path);
+			delete__abandoned_trash(trash_dir);
+		}
+		_exit(0);
+	}
+	if (child < 0) nob_return_defer(delete_directory(trash_path));
+	waitpid(child, NULL, 0);
+#endif
+defer:
+#if !defined(_WIN32)
+	if (lock_fd >= 0) close(lock_fd);
+#endif
+	nob_temp_rewind(temp_checkpoint);
+	return result;
+}
+
 enum RESULT nob_fetch_files(const char *dir_path, Nob_File_Paths *file_list, const char *extension) {
 	enum RESULT result = SUCCESS;
 	Nob_File_Type type = nob_get_file_type(dir_path);
@@ -129,6 +364,225 @@ defer:
 	return result;
 }
 
+// Match `path` against glob `pattern`. `*` and `?` stay inside one directory,
+// `**` crosses directories and `**/` also matches no directory at all.
+bool glob_match(const char *pattern, const char *path) {
+	for (; *pattern != '\0'; ++pattern, ++path) {
+		if (pattern[0] == '*' && pattern[1] == '*') {
+			pattern += 2;
+			if (*pattern == '/') pattern += 1;
+			for (const char *it = path; ; ++it) {
+				if (glob_match(pattern, it)) return true;
+				if (*it == '\0') return false;
+			}
+		}
+		if (*pattern == '*') {
+			for (const char *it = path; ; ++it) {
+				if (glob_match(pattern + 1, it)) return true;
+				if (*it == '\0' || *it == '/') return false;
+			}
+		}
+		if (*path == '\0') return false;
+		if (*pattern == '?' ? *path == '/' : *pattern != *path) return false;
+	}
+	return *path == '\0';
+}
+
+// Which files of a source tree to use, globs match paths relative to the tree root (`os/unix.c`).
+// No include globs takes every file.
+struct SourceGlobs {
+	const char **include;
+	size_t include_count;
+	const char **exclude;
+	size_t exclude_count;
+};
+
+static bool source_globs__any(const char **globs, size_t count, const char *path) {
+	for (size_t i = 0; i < count; ++i) {
+		if (glob_match(globs[i], path)) return true;
+	}
+	return false;
+}
+
+// Directories waiting to be listed, shared by the threads of nob_fetch_files_recursive()
+struct FetchQueue {
+#if !defined(_WIN32)
+	pthread_mutex_t lock;
+	pthread_cond_t changed;
+#endif
+	const char *root;
+	struct SourceGlobs globs;
+	Nob_File_Paths dirs;            // Relative to root with trailing slash, malloc'd
+	Nob_File_Paths files;           // Matched files, malloc'd
+	Nob_File_Paths listed;          // Every listed directory, malloc'd
+	size_t busy;                    // Threads listing a directory
+	bool failed;
+};
+
+static const char *fetch__join(const char *dir, const char *name, const char *suffix) {
+	size_t dir_length = strlen(dir);
+	size_t name_length = strlen(name);
+	size_t suffix_length = strlen(suffix);
+	char *path = (char*)malloc(dir_length + name_length + suffix_length + 1);
+	NOB_ASSERT(path != NULL && "Buy more RAM lol");
+	memcpy(path, dir, dir_length);
+	memcpy(path + dir_length, name, name_length);
+	memcpy(path + dir_length + name_length, suffix, suffix_length + 1);
+	return path;
+}
+
+// List one directory, scratch paths go to the thread's own temp storage.
+// Found paths are handed to other threads, those are malloced.
+static bool fetch__list_dir(struct FetchQueue *queue, const char *dir, Nob_File_Paths *dirs, Nob_File_Paths *files) {
+	bool result = true;
+	size_t temp_checkpoint = nob_temp_save();
+	Nob_Dir_Entry entry = {0};
+	const char *dir_path = nob_temp_sprintf("%s%s", queue->root, dir);
+	if (!nob_dir_entry_open(dir_path, &entry)) nob_return_defer(false);
+	while (nob_dir_entry_next(&entry)) {
+		if (strcmp(entry.name, ".") == 0 || strcmp(entry.name, "..") == 0) continue;
+		size_t entry_checkpoint = nob_temp_save();
+		Nob_File_Type type = nob_get_file_type(nob_temp_sprintf("%s%s", dir_path, entry.name));
+		nob_temp_rewind(entry_checkpoint);
+		if (type == NOB_FILE_DIRECTORY) {
+			const char *sub_dir = fetch__join(dir, entry.name, "/");
+			// `os/**` leaves out the whole directory without listing it
+			if (source_globs__any(queue->globs.exclude, queue->globs.exclude_count, sub_dir)) free((void*)sub_dir);
+			else nob_da_append(dirs, sub_dir);
+		}
+		else if (type == NOB_FILE_REGULAR) {
+			const char *file = fetch__join(dir, entry.name, "");
+			bool included = queue->globs.include_count == 0 || source_globs__any(queue->globs.include, queue->globs.include_count, file);
+			if (included && !source_globs__any(queue->globs.exclude, queue->globs.exclude_count, file)) nob_da_append(files, file);
+			else free((void*)file);
+		}
+	}
+	if (entry.error) result = false;
+
+defer:
+	nob_dir_entry_close(entry);
+	nob_temp_rewind(temp_checkpoint);
+	return result;
+}
+
+static void *fetch__worker(void *arg) {
+	struct FetchQueue *queue = (struct FetchQueue*)arg;
+	Nob_File_Paths dirs = {0};
+	Nob_File_Paths files = {0};
+#if !defined(_WIN32)
+	pthread_mutex_lock(&queue->lock);
+	for (;;) {
+		// Done when nothing is queued and nobody can queue more
+		while (queue->dirs.count == 0 && queue->busy > 0 && !queue->failed) pthread_cond_wait(&queue->changed, &queue->lock);
+		if (queue->dirs.count == 0 || queue->failed) break;
+		const char *dir = queue->dirs.items[--queue->dirs.count];
+		queue->busy += 1;
+		pthread_mutex_unlock(&queue->lock);
+
+		bool listed = fetch__list_dir(queue, dir, &dirs, &files);
+
+		pthread_mutex_lock(&queue->lock);
+		nob_da_append(&queue->listed, dir);
+		if (!listed) queue->failed = true;
+		nob_da_append_many(&queue->dirs, dirs.items, dirs.count);
+		nob_da_append_many(&queue->files, files.items, files.count);
+		dirs.count = 0;
+		files.count = 0;
+		queue->busy -= 1;
+		pthread_cond_broadcast(&queue->changed);
+	}
+	pthread_mutex_unlock(&queue->lock);
+#else
+	// TODO: CreateThread, until then one thread lists everything
+	while (queue->dirs.count > 0 && !queue->failed) {
+		const char *dir = queue->dirs.items[--queue->dirs.count];
+		if (!fetch__list_dir(queue, dir, &queue->dirs, &queue->files)) queue->failed = true;
+		nob_da_append(&queue->listed, dir);
+	}
+#endif
+	nob_da_free(dirs);
+	nob_da_free(files);
+	return NULL;
+}
+
+#if !defined(_WIN32)
+static void *fetch__thread(void *arg) {
+	fetch__worker(arg);
+	nob_temp_free();
+	return NULL;
+}
+#endif
+
+static int fetch__compare_paths(const void *a, const void *b) {
+	return strcmp(*(const char**)a, *(const char**)b);
+}
+
+// Like nob_fetch_files(), but lists subdirectories too, using several threads for big trees.
+// Appends paths relative to `dir_path` (`os/unix.c`, temp strings) sorted by name.
+// Optional `dir_list` receives the listed directories the same way (`os/`, root is ``).
+enum RESULT nob_fetch_files_recursive(const char *dir_path, Nob_File_Paths *file_list, Nob_File_Paths *dir_list, struct SourceGlobs globs) {
+	enum RESULT result = SUCCESS;
+	struct FetchQueue queue = {0};
+	queue.root = dir_path;
+	queue.globs = globs;
+	nob_da_append(&queue.dirs, fetch__join("", "", ""));
+
+#if !defined(_WIN32)
+	pthread_t threads[16];
+	size_t thread_count = (size_t)nob_nprocs();
+	if (thread_count > NOB_ARRAY_LEN(threads)) thread_count = NOB_ARRAY_LEN(threads);
+	if (thread_count < 1) thread_count = 1;
+	pthread_mutex_init(&queue.lock, NULL);
+	pthread_cond_init(&queue.changed, NULL);
+	// Calling thread works too
+	size_t started = 0;
+	for (; started + 1 < thread_count; ++started) {
+		if (pthread_create(&threads[started], NULL, fetch__thread, &queue) != 0) break;
+	}
+	fetch__worker(&queue);
+	for (size_t i = 0; i < started; ++i) pthread_join(threads[i], NULL);
+	pthread_mutex_destroy(&queue.lock);
+	pthread_cond_destroy(&queue.changed);
+#else
+	fetch__worker(&queue);
+#endif
+	if (queue.failed) nob_return_defer(FAILED);
+
+	qsort(queue.files.items, queue.files.count, sizeof(*queue.files.items), fetch__compare_paths);
+	for (size_t i = 0; i < queue.files.count; ++i) {
+		nob_da_append(file_list, nob_temp_strdup(queue.files.items[i]));
+	}
+	for (size_t i = 0; dir_list != NULL && i < queue.listed.count; ++i) {
+		nob_da_append(dir_list, nob_temp_strdup(queue.listed.items[i]));
+	}
+
+defer:
+	for (size_t i = 0; i < queue.dirs.count; ++i) free((void*)queue.dirs.items[i]);
+	for (size_t i = 0; i < queue.files.count; ++i) free((void*)queue.files.items[i]);
+	for (size_t i = 0; i < queue.listed.count; ++i) free((void*)queue.listed.items[i]);
+	nob_da_free(queue.dirs);
+	nob_da_free(queue.files);
+	nob_da_free(queue.listed);
+	return result;
+}
+
+// Create every missing directory leading to `file_path`
+enum RESULT mkdir_parents(const char *file_path) {
+	enum RESULT result = SUCCESS;
+	char path[1024] = {0};
+	snprintf(path, sizeof(path), "%s", file_path);
+	for (char *it = path + 1; *it != '\0'; ++it) {
+		if (*it != '/' && *it != '\\') continue;
+		char separator = *it;
+		*it = '\0';
+		if (nob_file_exists(path) != 1 && !nob_mkdir_if_not_exists(path)) nob_return_defer(FAILED);
+		*it = separator;
+	}
+
+defer:
+	return result;
+}
+
 Nob_String_View get_file_name_no_extension(const char *file_path) {
 	Nob_String_View sv = nob_sv_from_cstr(file_path);
 	unsigned int last_slash = 0;
@@ -227,6 +681,37 @@ void nob_cmd_link_lib(Nob_Cmd *cmd, const char *dir_path, const char *lib_name)
 #endif
 }
 
+static enum CC_FAMILY cc__family = CC_FAMILY_UNKNOWN;
+
+// Family of the compiler nob_cc() runs, the one nob itself was built with can be another.
+// Asked once with `--version`, gcc is assumed when that fails.
+enum CC_FAMILY cc_family(void) {
+	if (cc__family != CC_FAMILY_UNKNOWN) return cc__family;
+	cc__family = CC_FAMILY_GCC;
+	Nob_Cmd cmd = {0};
+	nob_cc(&cmd);
+	char command[256];
+	snprintf(command, sizeof(command), "%s --version", cmd.items[0]);
+	nob_cmd_free(cmd);
+#if defined(_WIN32)
+	FILE *output = _popen(command, "r");
+#else
+	FILE *output = popen(command, "r");
+#endif
+	if (output == NULL) return cc__family;
+	// `clang version`, `Apple clang version`, gcc never says it
+	char line[256];
+	while (fgets(line, sizeof(line), output) != NULL) {
+		if (strstr(line, "clang") != NULL) cc__family = CC_FAMILY_CLANG;
+	}
+#if defined(_WIN32)
+	_pclose(output);
+#else
+	pclose(output);
+#endif
+	return cc__family;
+}
+
 void nob_cmd_optimize(Nob_Cmd *cmd, enum OPTIMIZATION_OPTION option) {
 #if _MSC_VER
 	switch (option) {
@@ -274,6 +759,32 @@ void nob_cmd_optimize(Nob_Cmd *cmd, enum OPTIMIZATION_OPTION option) {
 #endif
 }
 
+// Profile guided optimization flags, needed for compiling and linking. `profile_dir` must end with a slash.
+void nob_cmd_pgo(Nob_Cmd *cmd, enum PGO_STAGE stage, const char *profile_dir) {
+#if _MSC_VER
+	// TODO: /GENPROFILE and /USEPROFILE are link flags and need /GL + /LTCG
+	(void)cmd; (void)stage; (void)profile_dir;
+#else
+	switch (stage) {
+		case PGO_NONE:
+			break;
+		case PGO_GENERATE:
+			nob_cmd_append(cmd, nob_temp_sprintf("-fprofile-generate=%s", profile_dir));
+			break;
+		case PGO_USE:
+			if (cc_family() == CC_FAMILY_CLANG) {
+				// Reads default.profdata merged from the .profraw files
+				nob_cmd_append(cmd, nob_temp_sprintf("-fprofile-use=%sdefault.profdata", profile_dir));
+			}
+			else {
+				// Code the training run didn't reach is not an error
+				nob_cmd_append(cmd, nob_temp_sprintf("-fprofile-use=%s", profile_dir), "-fprofile-correction", "-Wno-missing-profile");
+			}
+			break;
+	}
+#endif
+}
+
 void nob_cmd_error(Nob_Cmd *cmd, enum ERROR_OPTION level) {
 #if _MSC_VER
     switch (level) {
@@ -354,6 +865,24 @@ void nob_cmd_output_shared_object(Nob_Cmd *cmd, const char *src_path, const char
 #endif
 }
 
+// Output file of nob_cmd_output_shared_library() (temp string)
+const char *shared_library_path(const char *name, const char *out_dir) {
+#if defined(WINDOWS)
+	return nob_temp_sprintf("%s%s.dll", out_dir, name);
+#else
+	return nob_temp_sprintf("%s%s.so", out_dir, name);
+#endif
+}
+
+// Output file of nob_cmd_new_static_library() (temp string)
+const char *static_library_path(const char *name, const char *dir_path) {
+#if defined(_MSC_VER)
+	return nob_temp_sprintf("%s%s.lib", dir_path, name);
+#else
+	return nob_temp_sprintf("%slib%s.a", dir_path, name);
+#endif
+}
+
 void nob_cmd_output_shared_library(Nob_Cmd *cmd, const char *name, const char *out_dir, bool debug) {
 	// size_t temp_checkpoint = nob_temp_save();
 #if defined(_MSC_VER)
@@ -366,13 +895,11 @@ void nob_cmd_output_shared_library(Nob_Cmd *cmd, const char *name, const char *o
 #else
 	if (debug) nob_cmd_append(cmd, "-g");
 	nob_cmd_append(cmd, "-shared", "-o");
+	nob_cmd_append(cmd, shared_library_path(name, out_dir));
 	#if defined(WINDOWS)
-		nob_cmd_append(cmd, nob_temp_sprintf("%s%s.dll", out_dir, name));
 		// Create compile linking interface library
 		// TODO: need testing
 		//nob_cmd_append(cmd, nob_temp_sprintf("-Wl,--out-implib,\"%slib%s.lib\"", out_dir, name));
-	#elif defined(LINUX)
-		nob_cmd_append(cmd, nob_temp_sprintf("%s%s.so", out_dir, name));
 	#endif
 #endif
 	// nob_temp_rewind(temp_checkpoint);
@@ -390,8 +917,7 @@ void nob_cmd_new_static_library(Nob_Cmd *cmd, const char *name, const char *dir_
 	nob_cmd_append(cmd, output_file);
 #else
 	nob_cmd_append(cmd, "ar", "rcs");
-	const char *output_file = nob_temp_sprintf("%slib%s.a", dir_path, name);
-	nob_cmd_append(cmd, output_file);
+	nob_cmd_append(cmd, static_library_path(name, dir_path));
 #endif
 }
 
@@ -419,67 +945,86 @@ defer:
 	return result;
 }
 
-enum RESULT nob_cmd_process_source_dir(Nob_Cmd *item_cmd, const char *source_dir, const char *output_dir, const char *src_extension, bool debug, bool shared, bool force_rebuild) {
+// Ask compiler to write make style dependency file next to the object
+void nob_cmd_dependency_file(Nob_Cmd *cmd, const char *dep_path) {
+#if defined(_MSC_VER)
+	// TODO: /sourceDependencies produces JSON, needs own parser
+#else
+	nob_cmd_append(cmd, "-MMD", "-MF", dep_path);
+#endif
+}
+
+// Parse `target.o: src.c include/a.h \` dependency file into list of prerequisites (temp strings)
+enum RESULT nob_parse_dependency_file(const char *dep_path, Nob_File_Paths *deps) {
 	enum RESULT result = SUCCESS;
-	Nob_Cmd obj_cmd = {0};
-	Nob_Procs procs = {0};
-	Nob_File_Paths file_list = {0};
-	int rebuild_is_needed;
-	size_t temp_checkpoint = nob_temp_save();
-	if (!nob_mkdir_if_not_exists(output_dir)) nob_return_defer(FAILED);
+	Nob_String_Builder content = {0};
+	Nob_String_Builder token = {0};
+	if (!nob_read_entire_file(dep_path, &content)) nob_return_defer(FAILED);
 
-	if (nob_fetch_files(source_dir, &file_list, src_extension) == FAILED) {
-		assert(false);
+	// Skip target part. Colon must be followed by whitespace, so `C:\path` is not treated as separator
+	size_t i = 0;
+	for (; i < content.count; ++i) {
+		if (content.items[i] != ':') continue;
+		if (i + 1 == content.count || isspace((unsigned char)content.items[i + 1])) break;
+	}
+	if (i >= content.count) {
+		nob_log(NOB_ERROR, "Missing target separator in dependency file: %s", dep_path);
 		nob_return_defer(FAILED);
 	}
+	i += 1;
 
-	const char *src_name;
-	const char *src_file_path;
-	const char *bin_path;
-	Nob_String_View src_file;
-	for (int i = 0; i < file_list.count; ++i) {
-		src_file = get_file_name_no_extension(file_list.items[i]);
-		src_name = nob_temp_cstr_from_string_view(&src_file);
-		src_file_path = nob_temp_sprintf("%s%s%s", source_dir, src_name, src_extension);
-		// TODO: Add MSVC obj
-		bin_path = nob_temp_sprintf("%s%s.o", output_dir, src_name);
-		if (bin_path == NULL) {
-			nob_log(NOB_ERROR, "Failed to allocate binary file path cstr: %s", nob_temp_sprintf("%s%s.o", output_dir, src_name));
-			assert(false);
-			nob_return_defer(FAILED);
+	// Only the first rule is needed, it ends on a newline that isn't escaped
+	for (; i <= content.count; ++i) {
+		char c = i < content.count ? content.items[i] : '\n';
+		if (c == '\\' && i + 1 < content.count) {
+			char next = content.items[i + 1];
+			if (next == '\n' || next == '\r') {
+				i += 1;
+				if (next == '\r' && i + 1 < content.count && content.items[i + 1] == '\n') i += 1;
+				c = ' ';
+			}
+			else if (next == ' ' || next == '#') {
+				nob_da_append(&token, next);
+				i += 1;
+				continue;
+			}
 		}
-		rebuild_is_needed = nob_needs_rebuild1(bin_path, src_file_path);
-		if (rebuild_is_needed < 0) nob_return_defer(FAILED);
-		if (rebuild_is_needed == 0 && !force_rebuild) continue;
-		
-		// TODO: Add MSVC support/flags
-		nob_cc(&obj_cmd);
-		nob_cmd_append(&obj_cmd, "-c", src_file_path);
-		nob_cmd_append(&obj_cmd, "-o", bin_path);
-		// TODO: msvc version
-		if (shared) nob_cmd_append(&obj_cmd, "-fpic");
-		if (debug) nob_cmd_append(&obj_cmd, "-g");
-		nob_cmd_append_cmd(&obj_cmd, item_cmd);
-		if (!nob_cmd_run(&obj_cmd, .async = &procs)) {
-			nob_log(NOB_ERROR, "Appending build to queue failed: %s%s%s -> %s%s%s", source_dir, src_name, src_extension, output_dir, src_name, src_extension);
-			assert(false);
-			nob_return_defer(FAILED);
+		if (isspace((unsigned char)c)) {
+			if (token.count > 0) {
+				nob_da_append(deps, nob_temp_strndup(token.items, token.count));
+				token.count = 0;
+			}
+			if (c == '\n') break;
+			continue;
 		}
-		nob_temp_rewind(temp_checkpoint);
+		nob_da_append(&token, c);
 	}
 
-	// Wait on all the async processes to finish and reset procs dynamic array to 0
-	if (!nob_procs_flush(&procs)) {
-		nob_log(NOB_ERROR, "Parallel source build failed dir: %s -> %s", source_dir, output_dir);
-		assert(false);
-		nob_return_defer(FAILED);
+defer:
+	nob_sb_free(content);
+	nob_sb_free(token);
+	return result;
+}
+
+// Same as nob_needs_rebuild1, but also checks every header the source included last time.
+// Missing dependency file or vanished header means the object has to be rebuilt.
+int nob_needs_rebuild_dependency_file(const char *output_path, const char *source_path, const char *dep_path) {
+	int result = 0;
+	Nob_File_Paths deps = {0};
+	size_t temp_checkpoint = nob_temp_save();
+
+	if (nob_file_exists(dep_path) != 1) nob_return_defer(1);
+	if (nob_parse_dependency_file(dep_path, &deps) == FAILED) nob_return_defer(1);
+	nob_da_append(&deps, source_path);
+
+	for (size_t i = 0; i < deps.count; ++i) {
+		if (nob_file_exists(deps.items[i]) != 1) nob_return_defer(1);
 	}
+	result = nob_needs_rebuild(output_path, deps.items, deps.count);
 
 defer:
 	nob_temp_rewind(temp_checkpoint);
-	nob_cmd_free(obj_cmd);
-	nob_da_free(procs);
-	nob_da_free(file_list);
+	nob_da_free(deps);
 	return result;
 }
 
@@ -549,48 +1094,218 @@ defer:
 	return result;
 }
 
-// Downloads file using curl or fallbacks to wget
-enum RESULT download_file(const char *url, const char *dest) {
-	enum RESULT result = SUCCESS;
-	char download_cmd[2048] = {0};
-	snprintf(download_cmd, sizeof(download_cmd), "curl -fsSL \"%s\" -o \"%s\"", url, dest);
-	nob_log(NOB_INFO, "Downloading file: %s", dest);
-	if (system(download_cmd) == FAILED) {
-		snprintf(download_cmd, sizeof(download_cmd), "wget -q \"%s\" -O \"%s\"", url, dest);
-		if (system(download_cmd) == FAILED) {
-			nob_log(NOB_ERROR, "Failed to download %s\n", url);
-			assert(false);
-			nob_return_defer(FAILED);
-		}
+// 64-bit FNV-1a, start with HASH_SEED and feed the result back to chain data
+#define HASH_SEED 0xcbf29ce484222325ULL
+
+uint64_t hash_bytes(uint64_t hash, const void *data, size_t size) {
+	const unsigned char *bytes = (const unsigned char*)data;
+	for (size_t i = 0; i < size; ++i) {
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ULL;
 	}
+	return hash;
+}
+
+// Terminating zero is hashed too, so {"ab", "c"} and {"a", "bc"} differ
+uint64_t hash_cstr(uint64_t hash, const char *cstr) {
+	return hash_bytes(hash, cstr, strlen(cstr) + 1);
+}
+
+enum RESULT hash_file(uint64_t *hash, const char *file_path) {
+	enum RESULT result = SUCCESS;
+	Nob_String_Builder sb = {0};
+	if (!nob_read_entire_file(file_path, &sb)) nob_return_defer(FAILED);
+	*hash = hash_bytes(*hash, sb.items, sb.count);
+
 defer:
+	nob_sb_free(sb);
 	return result;
 }
 
-enum RESULT extract_tar_archive(const char *archive_path, const char *target_dir, unsigned int strip_lvl) {
-	enum RESULT result = SUCCESS;
-	char tar_cmd[2048] = {0};
-	snprintf(tar_cmd, sizeof(tar_cmd), "tar -xzf \"%s\" -C \"%s\" --strip-components=%d", archive_path, target_dir, strip_lvl);
+struct FileStat {
+	uint64_t device;             // 0 on Windows
+	uint64_t inode;              // 0 on Windows, only unique together with device
+	uint64_t size;
+	uint64_t mtime_ns;           // Whole seconds on Windows
+};
 
-	if (system(tar_cmd) != 0) {
-		nob_log(NOB_ERROR, "Failed to extract: %s -> %s\nCMD: %s", archive_path, target_dir, tar_cmd);
-		assert(false);
+// Follows symlinks, false when `path` doesn't exist
+bool file_stat(const char *path, struct FileStat *file) {
+#if defined(_WIN32)
+	struct _stat64 st;
+	if (_stat64(path, &st) != 0) return false;
+	file->device = 0;
+	file->inode = 0;
+	file->mtime_ns = (uint64_t)st.st_mtime * 1000000000ULL;
+#else
+	struct stat st;
+	if (stat(path, &st) != 0) return false;
+	file->device = (uint64_t)st.st_dev;
+	file->inode = (uint64_t)st.st_ino;
+	#if defined(__APPLE__)
+	file->mtime_ns = (uint64_t)st.st_mtimespec.tv_sec * 1000000000ULL + (uint64_t)st.st_mtimespec.tv_nsec;
+	#else
+	file->mtime_ns = (uint64_t)st.st_mtim.tv_sec * 1000000000ULL + (uint64_t)st.st_mtim.tv_nsec;
+	#endif
+#endif
+	file->size = (uint64_t)st.st_size;
+	return true;
+}
+
+static bool file__set_mtime(const char *path, uint64_t mtime_ns) {
+#if defined(_WIN32)
+	struct __utimbuf64 times = {(__time64_t)(mtime_ns / 1000000000ULL), (__time64_t)(mtime_ns / 1000000000ULL)};
+	return _utime64(path, &times) == 0;
+#else
+	struct timespec times[2];
+	times[0].tv_sec = times[1].tv_sec = (time_t)(mtime_ns / 1000000000ULL);
+	times[0].tv_nsec = times[1].tv_nsec = (long)(mtime_ns % 1000000000ULL);
+	return utimensat(AT_FDCWD, path, times, 0) == 0;
+#endif
+}
+
+// What sync_directory() did
+struct SyncStats {
+	size_t unchanged;
+	size_t linked;
+	size_t copied;
+	size_t deleted;
+};
+
+struct Sync {
+	const char *src_root;
+	const char *dst_root;
+	bool compare_hash;
+	bool failed;
+	struct SyncStats *stats;
+};
+
+// `root` + `path` inside another root, walk paths look like `root//name` when root ends with a slash
+static const char *sync__counterpart(const char *path, const char *root, const char *other_root) {
+	const char *relative = path + strlen(root);
+	while (*relative == '/' || *relative == '\\') relative += 1;
+	if (*relative == '\0') return nob_temp_strdup(other_root);
+	size_t length = strlen(other_root);
+	bool slash = length > 0 && (other_root[length - 1] == '/' || other_root[length - 1] == '\\');
+	return nob_temp_sprintf("%s%s%s", other_root, slash ? "" : "/", relative);
+}
+
+static bool sync__same_file(struct Sync *sync, const char *src_path, const char *dst_path, struct FileStat *src) {
+	struct FileStat dst = {0};
+	if (!file_stat(dst_path, &dst)) return false;
+	// Hardlinked earlier, inode numbers of other filesystems can match by chance
+	if (src->inode != 0 && src->device == dst.device && src->inode == dst.inode) return true;
+	if (src->size != dst.size || src->mtime_ns != dst.mtime_ns) return false;
+	if (!sync->compare_hash) return true;
+	uint64_t src_hash = HASH_SEED;
+	uint64_t dst_hash = HASH_SEED;
+	if (hash_file(&src_hash, src_path) == FAILED || hash_file(&dst_hash, dst_path) == FAILED) return false;
+	return src_hash == dst_hash;
+}
+
+static bool sync__link(const char *src_path, const char *dst_path) {
+#if defined(_WIN32)
+	return CreateHardLinkA(dst_path, src_path, NULL);
+#else
+	return link(src_path, dst_path) == 0;
+#endif
+}
+
+static bool sync__copy_entry(Nob_Walk_Entry entry) {
+	struct Sync *sync = (struct Sync*)entry.data;
+	size_t temp_checkpoint = nob_temp_save();
+	const char *dst_path = sync__counterpart(entry.path, sync->src_root, sync->dst_root);
+	// -1 when missing, nob_get_file_type() would log it
+	int dst_type = nob_file_exists(dst_path) == 1 ? (int)nob_get_file_type(dst_path) : -1;
+
+	if (entry.type == NOB_FILE_DIRECTORY) {
+		if (dst_type >= 0 && dst_type != NOB_FILE_DIRECTORY && !nob_delete_file(dst_path)) sync->failed = true;
+		else if (dst_type != NOB_FILE_DIRECTORY && !nob_mkdir_if_not_exists(dst_path)) sync->failed = true;
+		nob_temp_rewind(temp_checkpoint);
+		return !sync->failed;
+	}
+
+	struct FileStat src = {0};
+	if (!file_stat(entry.path, &src)) {
+		nob_log(NOB_ERROR, "Could not stat %s: %s", entry.path, strerror(errno));
+		sync->failed = true;
+		nob_temp_rewind(temp_checkpoint);
+		return false;
+	}
+	if (dst_type == NOB_FILE_REGULAR && sync__same_file(sync, entry.path, dst_path, &src)) {
+		sync->stats->unchanged += 1;
+		nob_temp_rewind(temp_checkpoint);
+		return true;
+	}
+
+	// Replace instead of writing through, old file may be a hardlink to a previous source
+	if (dst_type >= 0) {
+		if (dst_type == NOB_FILE_DIRECTORY) sync->failed = delete_directory(dst_path) == FAILED;
+		else sync->failed = !nob_delete_file(dst_path);
+	}
+	// Same filesystem shares the data, other filesystems and Windows without rights copy it
+	if (!sync->failed && sync__link(entry.path, dst_path)) {
+		sync->stats->linked += 1;
+	}
+	else if (!sync->failed && nob_copy_file(entry.path, dst_path)) {
+		// Copies keep source time, next sync compares equal
+		file__set_mtime(dst_path, src.mtime_ns);
+		sync->stats->copied += 1;
+	}
+	else {
+		sync->failed = true;
+	}
+	nob_temp_rewind(temp_checkpoint);
+	return !sync->failed;
+}
+
+static bool sync__delete_entry(Nob_Walk_Entry entry) {
+	struct Sync *sync = (struct Sync*)entry.data;
+	size_t temp_checkpoint = nob_temp_save();
+	const char *src_path = sync__counterpart(entry.path, sync->dst_root, sync->src_root);
+	// Post-order, directory children are already gone
+	if (entry.level > 0 && nob_file_exists(src_path) != 1) {
+		if (!nob_delete_file(entry.path)) sync->failed = true;
+		else sync->stats->deleted += 1;
+	}
+	nob_temp_rewind(temp_checkpoint);
+	return !sync->failed;
+}
+
+// Make `dst_dir` a copy of `src_dir` touching only what differs. Files compare by size and
+// modification time, with `compare_hash` also by content. Changed files are hardlinked when both
+// directories share a filesystem, copied otherwise. Files missing from `src_dir` are deleted.
+enum RESULT sync_directory(const char *src_dir, const char *dst_dir, bool compare_hash, struct SyncStats *stats) {
+	enum RESULT result = SUCCESS;
+	struct Sync sync = {src_dir, dst_dir, compare_hash, false, stats};
+	memset(stats, 0, sizeof(*stats));
+	if (nob_file_exists(dst_dir) != 1 && !nob_mkdir_if_not_exists(dst_dir)) nob_return_defer(FAILED);
+	if (!nob_walk_dir(dst_dir, sync__delete_entry, .data = &sync, .post_order = true) || sync.failed) {
+		nob_log(NOB_ERROR, "Failed to remove stale files of %s", dst_dir);
+		nob_return_defer(FAILED);
+	}
+	if (!nob_walk_dir(src_dir, sync__copy_entry, .data = &sync) || sync.failed) {
+		nob_log(NOB_ERROR, "Failed to sync %s to %s", src_dir, dst_dir);
 		nob_return_defer(FAILED);
 	}
+
 defer:
 	return result;
 }
 
-enum RESULT extract_zip_archive(const char *archive_path, const char *target_dir, unsigned int strip_lvl) {
+// Downloads file using curl or fallbacks to wget
+enum RESULT download_file(const char *url, const char *dest) {
 	enum RESULT result = SUCCESS;
-	char zip_cmd[2048] = {0};
-	// snprintf(zip_cmd, sizeof(zip_cmd), "powershell -command \"Expand-Archive -Force '%s' '%s'", archive_path, target_dir);
-	snprintf(zip_cmd, sizeof(zip_cmd), "tar -xf \"%s\" -C \"%s\" --strip-components=%d", archive_path, target_dir, strip_lvl);
-
-	if (system(zip_cmd)) {
-		nob_log(NOB_ERROR, "Failed to extract: %s -> %s\nCMD: %s", archive_path, target_dir, zip_cmd);
-		assert(false);
-		nob_return_defer(FAILED);
+	char download_cmd[2048] = {0};
+	snprintf(download_cmd, sizeof(download_cmd), "curl -fsSL \"%s\" -o \"%s\"", url, dest);
+	nob_log(NOB_INFO, "Downloading file: %s", dest);
+	if (system(download_cmd) == FAILED) {
+		snprintf(download_cmd, sizeof(download_cmd), "wget -q \"%s\" -O \"%s\"", url, dest);
+		if (system(download_cmd) == FAILED) {
+			nob_log(NOB_ERROR, "Failed to download %s\n", url);
+			assert(false);
+			nob_return_defer(FAILED);
+		}
 	}
 defer:
 	return result;
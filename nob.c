@@ -5,6 +5,19 @@
 #include <stdio.h>
 #include <string.h>
 #include "include/nob_utils.h"
+#include "include/nob_graph.h"
+#include "include/nob_build.h"
+#include "include/nob_trace.h"
+#include "include/nob_archive.h"
+#if defined(LINUX)
+#	include <sys/inotify.h>
+#	include <sys/socket.h>
+#	include <sys/time.h>
+#	include <sys/un.h>
+#	include <signal.h>
+#	include <poll.h>
+#	include <unistd.h>
+#endif
 
 #define PROJECT_NAME "nob_raylib"
 
@@ -13,13 +26,33 @@
 #define BUILD_FOLDER "build/"
 #define OBJ_FOLDER BUILD_FOLDER "obj/"
 #define LIB_FOLDER BUILD_FOLDER "lib/"
+#define CACHE_FOLDER BUILD_FOLDER "cache/"
+// Deleted directories wait here for the background delete, see delete_directory_background()
+#define TRASH_FOLDER BUILD_FOLDER ".trash"
+#define PCH_FOLDER BUILD_FOLDER "pch/"
+#define PGO_FOLDER BUILD_FOLDER "pgo/"
+#define PGO_TRAINED_FILE_NAME "trained"
+#define PGO_TRAINING_FRAMES "600"
+// Quiet time after the last change before -watch rebuilds
+#define WATCH_DEBOUNCE_MS 30
 #define DEBUG_FOLDER BUILD_FOLDER "debug/"
 #define RELEASE_FOLDER BUILD_FOLDER "release/"
 #define WEB_FOLDER BUILD_FOLDER "web/"
 #define RESOURCES_FOLDER "resources/"
 #define DOWNLOAD_FOLDER "download/"
 #define DEPENDENCY_FOLDER "dependencies/"
-#define CONFIG_FILE_NAME ".config"
+#define FINGERPRINTS_FILE_NAME ".fingerprints"
+#define TRACE_FILE_NAME "trace.json"
+#define DAEMON_SOCKET_NAME "nob.sock"
+#define DAEMON_MAGIC 0x444e424fu   // "OBND"
+// Request has to arrive this soon after connecting
+#define DAEMON_RECV_TIMEOUT_MS 1000
+#define SNAPSHOT_FILE_NAME ".snapshot"
+#define BENCH_FOLDER BUILD_FOLDER "bench/"
+#define BENCH_COPY_RUNS 5
+// Synthetic project of -bench-build, relative to root, the benchmark runs inside it
+#define BENCH_PROJECT_FOLDER BENCH_FOLDER "project/"
+#define BENCH_RESULTS_NAME "build_results"
 
 #define RAYLIB_TAG "5.5"
 #define RAYLIB_DIR_NAME "raylib/"
@@ -27,6 +60,8 @@
 #define RAYLIB_TAR_FILE "raylib.tar.gz"
 #define RAYLIB_ARCHIVE DOWNLOAD_FOLDER RAYLIB_TAR_FILE
 #define RAYLIB_SRC_DIR DEPENDENCY_FOLDER RAYLIB_DIR_NAME "src/"
+// raylib's config.h without features of raylib_disabled_features, see setup_raylib_config()
+#define RAYLIB_CONFIG_FILE BUILD_FOLDER "raylib_config.h"
 
 #define EMSCRIPTEN_TAG "4.0.20"
 #define EMSCRIPTEN_DIR_NAME "emsdk/"
@@ -36,40 +71,265 @@
 
 static const char *project_name = PROJECT_NAME;
 
-// For tracking last build settings that needs to be rebuild
-static int config_version = 1;
-
 // It is set by build input arguments
 static struct SavedConfig current_config = {
 	false,				// -debug
 	PLATFORM_DESKTOP,	// -platform <target>
 	false,				// -wayland
 };
-// If successfully loaded config it will point to the data
-static struct SavedConfig *previous_config = NULL;
+// -configs debug,release builds several configurations in one graph, current_config is switched
+// to each while planning. Without it the only one is current_config itself.
+static struct SavedConfig build_configs[3] = {0};
+static size_t build_configs_count = 0;
 static char starting_cwd[1024] = {0};
+// Max parallel build processes, 0 is nob_nprocs()
+static size_t max_jobs = 0;
+// Object cache size limit in MiB, set with -cache-size
+static size_t cache_size_mib = 1024;
+// Precompiled headers for modules that use them, turned off with -no-pch
+static bool use_pch = true;
+// -optimize pgo builds instrumented binaries, trains them, then builds with the profile
+static bool use_pgo = false;
+static enum PGO_STAGE pgo_stage = PGO_NONE;
+// Profile data of current configuration and sources, see set_pgo_directory()
+static char pgo_dir[512] = {0};
+// Hash of the trained profile data, see pgo__hash_profile()
+static uint64_t pgo_profile_hash = 0;
+// Stay resident after the build and rebuild on changes
+static bool watch = false;
+// Stay resident and serve builds to ./nob clients over BUILD_FOLDER DAEMON_SOCKET_NAME
+static bool daemon_mode = false;
+// Run copy benchmark with a file of this many MiB instead of building, set with -bench-copy
+static size_t bench_copy_mib = 0;
+// Shape of the synthetic project of -bench-build, no modules means no benchmark
+static struct BenchShape {
+	size_t modules;                 // Static libraries like src/os/
+	size_t files;                   // Sources per module
+	size_t headers;                 // Shared headers in include/
+	size_t fanout;                  // Headers included by each source and header
+	size_t plugins;                 // Shared libraries like plug_template/, files/2 sources each
+} bench_shape = {0};
+// Resource sync also compares content of files with equal size and time, set with -sync-hash
+static bool sync_hash = false;
+
+// Modules compile_configuration() plans, -only and -rebuild pick them by name
+enum TARGET {
+	TARGET_RAYLIB,
+	TARGET_LOAD_LIBRARY,
+	TARGET_OS,
+	TARGET_PLUG_HOST,
+	TARGET_MAIN,
+	TARGET_TEST_DLL,
+	TARGET_PLUG_TEMPLATE,
+	TARGET_COUNT,
+};
+
+static const struct {
+	const char *name;
+	enum TARGET deps[4];            // Linked into it
+	size_t deps_count;
+} targets[TARGET_COUNT] = {
+	[TARGET_RAYLIB] = {"raylib", {0}, 0},
+	[TARGET_LOAD_LIBRARY] = {"load_library", {0}, 0},
+	[TARGET_OS] = {"os", {0}, 0},
+	[TARGET_PLUG_HOST] = {"plug_host", {0}, 0},
+	[TARGET_MAIN] = {"main", {TARGET_RAYLIB, TARGET_LOAD_LIBRARY, TARGET_OS, TARGET_PLUG_HOST}, 4},
+	[TARGET_TEST_DLL] = {"test_dll", {0}, 0},
+	[TARGET_PLUG_TEMPLATE] = {"plug_template", {0}, 0},
+};
+
+// Planned targets, all of them unless -only or -rebuild names some
+static bool target_selected[TARGET_COUNT] = {0};
+static bool targets_scoped = false;
+// Objects of these are compiled again even when up to date, set with -rebuild
+static bool target_rebuild[TARGET_COUNT] = {0};
+// Any -rebuild target, such a run is never answered from the snapshot or a daemon's dirty flags
+static bool rebuild_forced = false;
+
+// Profile flags of the current PGO stage, for compiling and linking
+void get_pgo_flags(Nob_Cmd *cmd) {
+	nob_cmd_pgo(cmd, pgo_stage, pgo_dir);
+	// Profile data isn't an argument, the define puts it in fingerprints and object cache keys
+	if (pgo_stage == PGO_USE) nob_cmd_define(cmd, nob_temp_sprintf("NOB_PGO_PROFILE=0x%016llx", (unsigned long long)pgo_profile_hash));
+}
+
+// Objects and static libraries of each configuration are kept apart, -configs builds them side by side
+const char* get_obj_directory() {
+	if (current_config.platform == PLATFORM_WEB) {
+		return OBJ_FOLDER "web/";
+	}
+	else if (current_config.is_debug) {
+		return OBJ_FOLDER "debug/";
+	}
+	else {
+		return OBJ_FOLDER "release/";
+	}
+}
+
+const char* get_lib_directory() {
+	if (current_config.platform == PLATFORM_WEB) {
+		return LIB_FOLDER "web/";
+	}
+	else if (current_config.is_debug) {
+		return LIB_FOLDER "debug/";
+	}
+	else {
+		return LIB_FOLDER "release/";
+	}
+}
 
 //--------------Raylib----------------------------------------------------------
+// Feature profile - raylib features this project doesn't use, names of raylib's config.h
+// `SUPPORT_<name>` defines. Calling into a left out module or loading a left out format fails.
+// Only NULL builds full raylib.
+static const char *raylib_disabled_features[] = {
+	"MODULE_RMODELS",           // Model formats and mesh generation go with it
+	"MODULE_RAUDIO",            // Audio formats and miniaudio go with it
+	"GIF_RECORDING",
+	"FILEFORMAT_GIF",
+	"FILEFORMAT_QOI",
+	"FILEFORMAT_DDS",
+	"FILEFORMAT_FNT",
+	NULL,
+};
+
+// Translation units that are empty without their module
+static const struct {
+	const char *file;
+	const char *feature;
+} raylib_module_sources[] = {
+	{"rshapes.c", "MODULE_RSHAPES"},
+	{"rtextures.c", "MODULE_RTEXTURES"},
+	{"rtext.c", "MODULE_RTEXT"},
+	{"rmodels.c", "MODULE_RMODELS"},
+	{"raudio.c", "MODULE_RAUDIO"},
+};
+
+// Index in raylib_disabled_features, -1 for enabled feature
+static int raylib_feature_disabled(Nob_String_View feature) {
+	for (int i = 0; raylib_disabled_features[i] != NULL; ++i) {
+		if (nob_sv_eq(feature, nob_sv_from_cstr(raylib_disabled_features[i]))) return i;
+	}
+	return -1;
+}
+
+// Write RAYLIB_CONFIG_FILE from raylib's config.h with disabled features commented out and make
+// raylib's objects force include it instead (EXTERNAL_CONFIG_FLAGS). Profile fingerprint goes to
+// the command too, so objects built with another profile are never reused.
+enum RESULT setup_raylib_config(Nob_Cmd *cmd) {
+	enum RESULT result = SUCCESS;
+	Nob_String_Builder config = {0};
+	Nob_String_Builder sb = {0};
+	Nob_String_Builder existing = {0};
+	// Bit per disabled feature seen in config.h
+	uint64_t disabled_found = 0;
+	if (raylib_disabled_features[0] == NULL) nob_return_defer(SUCCESS);
+	if (!nob_read_entire_file(RAYLIB_SRC_DIR "config.h", &config)) nob_return_defer(FAILED);
+	build_snapshot_add(RAYLIB_SRC_DIR "config.h");
+
+	uint64_t profile = HASH_SEED;
+	nob_sb_append_cstr(&sb, "// Generated by nob from raylib's config.h and raylib_disabled_features, don't edit\n");
+	Nob_String_View content = nob_sv_from_parts(config.items, config.count);
+	while (content.count > 0) {
+		Nob_String_View line = nob_sv_chop_by_delim(&content, '\n');
+		Nob_String_View define = nob_sv_trim_left(line);
+		int disabled = -1;
+		if (nob_sv_starts_with(define, nob_sv_from_cstr("#define"))) {
+			nob_sv_chop_left(&define, strlen("#define"));
+			define = nob_sv_trim_left(define);
+			if (nob_sv_starts_with(define, nob_sv_from_cstr("SUPPORT_"))) {
+				nob_sv_chop_left(&define, strlen("SUPPORT_"));
+				size_t length = 0;
+				while (length < define.count && !isspace((unsigned char)define.data[length])) length += 1;
+				disabled = raylib_feature_disabled(nob_sv_from_parts(define.data, length));
+			}
+		}
+		if (disabled >= 0) {
+			nob_sb_append_cstr(&sb, "// ");
+			disabled_found |= 1ULL << (disabled % 64);
+		}
+		nob_sb_append_buf(&sb, line.data, line.count);
+		nob_sb_append_cstr(&sb, "\n");
+	}
+	for (int i = 0; raylib_disabled_features[i] != NULL; ++i) {
+		profile = hash_cstr(profile, raylib_disabled_features[i]);
+		// Typo or feature raylib doesn't have anymore
+		if ((disabled_found & (1ULL << (i % 64))) == 0) {
+			nob_log(NOB_WARNING, "Disabled raylib feature %s is not in " RAYLIB_SRC_DIR "config.h", raylib_disabled_features[i]);
+		}
+	}
+
+	// Rewriting unchanged config would rebuild all of raylib
+	if (nob_file_exists(RAYLIB_CONFIG_FILE) != 1 || !nob_read_entire_file(RAYLIB_CONFIG_FILE, &existing) ||
+		existing.count != sb.count || memcmp(existing.items, sb.items, sb.count) != 0) {
+		if (!nob_write_entire_file(RAYLIB_CONFIG_FILE, sb.items, sb.count)) nob_return_defer(FAILED);
+	}
+	build_snapshot_add_output(RAYLIB_CONFIG_FILE);
+	nob_cmd_define(cmd, "EXTERNAL_CONFIG_FLAGS");
+	nob_cmd_append(cmd, "-include", RAYLIB_CONFIG_FILE);
+	nob_cmd_define(cmd, nob_temp_sprintf("NOB_RAYLIB_PROFILE=0x%016llx", (unsigned long long)profile));
+
+defer:
+	nob_sb_free(config);
+	nob_sb_free(sb);
+	nob_sb_free(existing);
+	return result;
+}
+
 const char *get_raylib_platform(enum PLATFORM_TARGET platform) {
 	switch (platform) {
-		case PLATFORM_DESKTOP_GLFW: return "PLATFORM=PLATFORM_DESKTOP_GLFW";
-		case PLATFORM_DESKTOP_SDL: return "PLATFORM=PLATFORM_DESKTOP_SDL";
-		case PLATFORM_DESKTOP_RGFW: return "PLATFORM=PLATFORM_DESKTOP_RGFW";
-		case PLATFORM_WEB: return "PLATFORM=PLATFORM_WEB";
-		case PLATFORM_DRM: return "PLATFORM=PLATFORM_DRM";
-		case PLATFORM_ANDROID: return "PLATFORM=PLATFORM_ANDROID";
-		default: return "PLATFORM=PLATFORM_DESKTOP";
+		case PLATFORM_DESKTOP_GLFW: return "PLATFORM_DESKTOP_GLFW";
+		case PLATFORM_DESKTOP_SDL: return "PLATFORM_DESKTOP_SDL";
+		case PLATFORM_DESKTOP_RGFW: return "PLATFORM_DESKTOP_RGFW";
+		case PLATFORM_WEB: return "PLATFORM_WEB";
+		case PLATFORM_DRM: return "PLATFORM_DRM";
+		case PLATFORM_ANDROID: return "PLATFORM_ANDROID";
+		// Raylib's Makefile maps PLATFORM_DESKTOP to GLFW backend
+		default: return "PLATFORM_DESKTOP_GLFW";
+	}
+}
+
+// Flags raylib's src/Makefile would use
+void get_raylib_defines(Nob_Cmd *cmd) {
+	nob_cmd_define(cmd, get_raylib_platform(current_config.platform));
+	switch (current_config.platform) {
+		case (PLATFORM_WEB):
+		case (PLATFORM_DRM):
+		case (PLATFORM_ANDROID):
+			nob_cmd_define(cmd, "GRAPHICS_API_OPENGL_ES2");
+			break;
+		default:
+			nob_cmd_define(cmd, "GRAPHICS_API_OPENGL_33");
+			break;
+	}
+	nob_cmd_define(cmd, "_GNU_SOURCE");
+#if defined(_MSC_VER)
+	// TODO: MSVC flags
+#else
+	nob_cmd_append(cmd, "-Wall", "-std=c99", "-fno-strict-aliasing", "-Wno-missing-braces", "-Werror=pointer-arith", "-Werror=implicit-function-declaration");
+	if (!current_config.is_debug) nob_cmd_append(cmd, "-O1");
+#endif
+	nob_cmd_include_direction(cmd, RAYLIB_SRC_DIR);
+	nob_cmd_include_direction(cmd, RAYLIB_SRC_DIR "external/glfw/include");
+#if defined(__MINGW32__)
+	nob_cmd_include_direction(cmd, RAYLIB_SRC_DIR "external/glfw/deps/mingw");
+#endif
+#if defined(LINUX)
+	// TODO: _GLFW_WAYLAND when current_config.enable_wayland
+	if (current_config.platform == PLATFORM_DESKTOP || current_config.platform == PLATFORM_DESKTOP_GLFW) {
+		nob_cmd_define(cmd, "_GLFW_X11");
 	}
+#endif
 }
 
 void link_raylib(Nob_Cmd *cmd) {
 #if defined(_MSC_VER)
 	char path_buf[1024] = {0};
-	snprintf(path_buf, sizeof(path_buf), "%s", RAYLIB_SRC_DIR);
+	snprintf(path_buf, sizeof(path_buf), "%s", get_lib_directory());
 	swap_dir_slashes(path_buf, sizeof(path_buf));
     nob_cmd_append(cmd, nob_temp_sprintf("%sraylib.lib", path_buf));
 #else
-	nob_cmd_append(cmd, "-L", RAYLIB_SRC_DIR, "-lraylib");
+	nob_cmd_append(cmd, nob_temp_sprintf("-L%s", get_lib_directory()), "-lraylib");
 #endif
 
 	switch (current_config.platform) {
@@ -110,7 +370,10 @@ enum RESULT download_raylib() {
 
 	// Download
 	if (!nob_file_exists(RAYLIB_ARCHIVE)) {
-		if (download_file(raylib_url, RAYLIB_ARCHIVE) == FAILED) {
+		size_t phase = trace_phase_begin("download raylib");
+		enum RESULT downloaded = download_file(raylib_url, RAYLIB_ARCHIVE);
+		trace_phase_end(phase);
+		if (downloaded == FAILED) {
 			assert(false);
 			nob_return_defer(FAILED);
 		}
@@ -124,7 +387,10 @@ enum RESULT download_raylib() {
 	// Extract
 	if (!nob_mkdir_if_not_exists(DEPENDENCY_FOLDER RAYLIB_DIR_NAME)) nob_return_defer(FAILED);
 	if (!nob_file_exists(DEPENDENCY_FOLDER RAYLIB_DIR_NAME "README.md")) {
-		if(extract_tar_archive(RAYLIB_ARCHIVE, DEPENDENCY_FOLDER RAYLIB_DIR_NAME, 1)) {
+		size_t phase = trace_phase_begin("extract raylib");
+		enum RESULT extracted = extract_tar_archive(RAYLIB_ARCHIVE, DEPENDENCY_FOLDER RAYLIB_DIR_NAME, 1);
+		trace_phase_end(phase);
+		if (extracted) {
 			assert(false);
 			nob_return_defer(FAILED);
 		}
@@ -135,54 +401,109 @@ defer:
 	return result;
 }
 
-enum RESULT compile_raylib(bool force_rebuild, Nob_Cmd *link_cmd) {
+enum RESULT compile_raylib(struct BuildGraph *graph, bool force_rebuild, struct BuildJobIds *link_deps) {
 	enum RESULT result = SUCCESS;
-	Nob_Cmd raylib_cmd = {0};
 	size_t temp_checkpoint = nob_temp_save();
+	Nob_File_Paths children = {0};
+	Nob_File_Paths sources = {0};
+	Nob_File_Paths objects = {0};
+	Nob_Cmd obj_cmd = {0};
+	Nob_Cmd lib_cmd = {0};
+	size_t objects_job;
 
-	// Compile
-	bool need_rebuild = force_rebuild || (previous_config != NULL && previous_config->platform != current_config.platform);
-	// TODO: match check in context of compiler (*.a doesn't work for msvc)
-	if (!nob_file_exists(RAYLIB_SRC_DIR "libraylib.a") || need_rebuild) {
-		nob_log(NOB_INFO, "Changing directory: %s ", RAYLIB_SRC_DIR);
-		if (!nob_set_current_dir(nob_temp_sprintf("./%s", RAYLIB_SRC_DIR))) {
-			nob_log(NOB_ERROR, "Failed to change to directory: %s", RAYLIB_SRC_DIR);
-			assert(false);
-			nob_return_defer(FAILED);
-		}
-
-		nob_cmd_make(&raylib_cmd);
-		const char *raylib_platform = get_raylib_platform(current_config.platform);
-		nob_cmd_append(&raylib_cmd, raylib_platform, "-j4");
+	bool is_shared = false;
+	bool uses_glfw = current_config.platform == PLATFORM_DESKTOP || current_config.platform == PLATFORM_DESKTOP_GLFW;
 
-		if (!nob_cmd_run(&raylib_cmd)) {
-			nob_log(NOB_ERROR, "Failed to compile raylib");
-			assert(false);
-			nob_return_defer(FAILED);
+	// Every translation unit sits directly in src/, platform backends and external libs are included by them
+	if (nob_fetch_files(RAYLIB_SRC_DIR, &children, ".c") == FAILED) {
+		nob_log(NOB_ERROR, "Failed to fetch raylib sources: %s", RAYLIB_SRC_DIR);
+		assert(false);
+		nob_return_defer(FAILED);
+	}
+	for (size_t i = 0; i < children.count; ++i) {
+		// TODO: APPLE compiles rglfw.c as objective-c
+		if (!uses_glfw && strcmp(children.items[i], "rglfw.c") == 0) continue;
+		bool module_disabled = false;
+		for (size_t j = 0; j < NOB_ARRAY_LEN(raylib_module_sources); ++j) {
+			if (strcmp(children.items[i], raylib_module_sources[j].file) != 0) continue;
+			module_disabled = raylib_feature_disabled(nob_sv_from_cstr(raylib_module_sources[j].feature)) >= 0;
 		}
+		if (module_disabled) continue;
+		nob_da_append(&sources, children.items[i]);
 	}
 
-defer:
-	nob_log(NOB_INFO, "Changing directory: %s ", starting_cwd);
-	if (!nob_set_current_dir(starting_cwd)) {
-		nob_log(NOB_ERROR, "Failed to move back to root directory");
+	// Object files
+	get_raylib_defines(&obj_cmd);
+	get_pgo_flags(&obj_cmd);
+	if (setup_raylib_config(&obj_cmd) == FAILED) {
+		nob_log(NOB_ERROR, "Failed to generate raylib config from feature profile");
 		assert(false);
-		result = FAILED;
-		goto defer_2;
+		nob_return_defer(FAILED);
 	}
+	enum RESULT obj_result = nob_cmd_process_source_files(
+		graph, &obj_cmd, RAYLIB_SRC_DIR, &sources, nob_temp_sprintf("%sraylib/", get_obj_directory()), ".c",
+		current_config.is_debug, is_shared, force_rebuild, &objects, &objects_job);
 
-	if (!nob_file_exists(RAYLIB_SRC_DIR "libraylib.a")) {
-		nob_log(NOB_ERROR, "libraylib.a disappeared!!!");
+	if (obj_result == FAILED) {
+		nob_log(NOB_ERROR, "Failed building raylib objects");
 		assert(false);
-		result = FAILED;
-		goto defer_2;
+		nob_return_defer(FAILED);
 	}
 
-defer_2:
+	// static lib
+	// TODO: emar for web
+	nob_cmd_new_static_library(&lib_cmd, "raylib", get_lib_directory());
+	nob_cmd_input_files(&lib_cmd, &objects);
+	size_t lib_job = build_add_archive_job(graph, static_library_path("raylib", get_lib_directory()), &lib_cmd);
+	build_graph_add_dependency(graph, lib_job, objects_job);
+	build_job_add_inputs(graph, lib_job, &objects);
+	nob_da_append(link_deps, lib_job);
+
+defer:
+	nob_cmd_free(obj_cmd);
+	nob_cmd_free(lib_cmd);
+	nob_da_free(children);
+	nob_da_free(sources);
+	nob_da_free(objects);
 	nob_temp_rewind(temp_checkpoint);
 	return result;
 }
 
+//--------------Targets---------------------------------------------------------
+// Select `target` with everything it links, `rebuild` forces all of them to compile again
+static void target__select(enum TARGET target, bool rebuild) {
+	target_selected[target] = true;
+	if (rebuild) {
+		target_rebuild[target] = true;
+		rebuild_forced = true;
+	}
+	for (size_t i = 0; i < targets[target].deps_count; ++i) {
+		target__select(targets[target].deps[i], rebuild);
+	}
+}
+
+// Comma separated target names of -only and -rebuild
+enum RESULT select_targets(const char *names, bool rebuild) {
+	enum RESULT result = SUCCESS;
+	Nob_String_View list = nob_sv_from_cstr(names);
+	targets_scoped = true;
+	while (list.count > 0) {
+		Nob_String_View name = nob_sv_chop_by_delim(&list, ',');
+		size_t target = 0;
+		while (target < TARGET_COUNT && !nob_sv_eq(name, nob_sv_from_cstr(targets[target].name))) target += 1;
+		// Executable goes by its own name too
+		if (target == TARGET_COUNT && nob_sv_eq(name, nob_sv_from_cstr(project_name))) target = TARGET_MAIN;
+		if (target == TARGET_COUNT) {
+			nob_log(NOB_ERROR, "Unknown target `"SV_Fmt"`, expected raylib, load_library, os, plug_host, main, test_dll or plug_template", SV_Arg(name));
+			nob_return_defer(FAILED);
+		}
+		target__select((enum TARGET)target, rebuild);
+	}
+
+defer:
+	return result;
+}
+
 // TODO: -------------Emscripten--------------------------------------------------------
 enum RESULT download_emscripten() {
 	enum RESULT result = SUCCESS;
@@ -329,56 +650,96 @@ const char* get_target_directory() {
 	}
 }
 
-enum RESULT setup_resources() {
-	enum RESULT result = SUCCESS;
-	const char *target_resources_folder;
+// Precompiled headers are only valid for flags they were built with
+const char* get_pch_directory() {
+	if (current_config.platform == PLATFORM_WEB) {
+		return PCH_FOLDER "web/";
+	}
+	else if (current_config.is_debug) {
+		return PCH_FOLDER "debug/";
+	}
+	else {
+		return PCH_FOLDER "release/";
+	}
+}
+
+// Copy of resources next to the executable, NULL when it uses the ones at root
+const char* get_target_resources_directory() {
 	if (current_config.platform == PLATFORM_WEB) {
-		target_resources_folder = WEB_FOLDER RESOURCES_FOLDER;
+		return WEB_FOLDER RESOURCES_FOLDER;
 	}
 	else if (!current_config.is_debug) {
-		target_resources_folder = RELEASE_FOLDER RESOURCES_FOLDER;
+		return RELEASE_FOLDER RESOURCES_FOLDER;
 	}
 	else {
 		// Debug use resource at root
-		goto defer;
+		return NULL;
 	}
-	
-	if (nob_file_exists(target_resources_folder)) {
-		if (delete_directory(target_resources_folder) == FAILED) {
+}
+
+// Make build_configs[index] current, compile_* functions plan for it
+void use_config(size_t index) {
+	current_config = build_configs[index];
+	build_pch.dir = get_pch_directory();
+}
+
+// Object cache and precompiled headers as -cache and -pch set them, relative to the current directory
+enum RESULT setup_build_cache() {
+	if (mkdir_parents(CACHE_FOLDER) == FAILED || mkdir_parents(PCH_FOLDER) == FAILED) return FAILED;
+	build_cache.enabled = cache_size_mib > 0;
+	build_cache.dir = CACHE_FOLDER;
+	build_cache.max_size = cache_size_mib * 1024 * 1024;
+	build_pch.enabled = use_pch;
+	use_config(0);
+	return SUCCESS;
+}
+
+enum RESULT setup_resources() {
+	enum RESULT result = SUCCESS;
+	// Resources belong to the executable, -only plug_template doesn't touch them
+	if (!target_selected[TARGET_MAIN]) return SUCCESS;
+	for (size_t i = 0; i < build_configs_count; ++i) {
+		use_config(i);
+		const char *target_resources_folder = get_target_resources_directory();
+		if (target_resources_folder == NULL) continue;
+
+		struct SyncStats stats = {0};
+		if (sync_directory(RESOURCES_FOLDER, target_resources_folder, sync_hash, &stats) == FAILED) {
 			assert(false);
 			nob_return_defer(FAILED);
 		}
-	}
-	if (!nob_mkdir_if_not_exists(target_resources_folder)) nob_return_defer(FAILED);
-
-	if (!nob_copy_directory_recursively(RESOURCES_FOLDER, target_resources_folder)) {
-		assert(false);
-		nob_return_defer(FAILED);
+		if (stats.linked + stats.copied + stats.deleted > 0) {
+			nob_log(NOB_INFO, "Resources %s: %zu linked, %zu copied, %zu deleted, %zu unchanged",
+				target_resources_folder, stats.linked, stats.copied, stats.deleted, stats.unchanged);
+		}
 	}
 
 defer:
+	use_config(0);
 	return result;
 }
 
-enum RESULT compile_plug(bool force_rebuild, const char *source_dir, const char *plug_name) {
+enum RESULT compile_plug(struct BuildGraph *graph, bool force_rebuild, const char *source_dir, const char *plug_name) {
 	// Reference - https://web.archive.org/web/20201109103748/http://www.mingw.org/wiki/sampledll
 	enum RESULT result = SUCCESS;
 	size_t temp_start = nob_temp_save();
-	const char *obj_dir = nob_temp_sprintf( OBJ_FOLDER"%s", source_dir);
+	const char *obj_dir = nob_temp_sprintf("%s%s", get_obj_directory(), source_dir);
 
 	size_t temp_checkpoint = nob_temp_save();
-	Nob_File_Paths file_list = {0};
+	Nob_File_Paths objects = {0};
 	Nob_Cmd obj_cmd = {0};
 	Nob_Cmd lib_cmd = {0};
+	size_t objects_job;
 
 	bool is_shared = true;
 	nob_cc_flags(&obj_cmd);
 	nob_cmd_optimize(&obj_cmd, current_config.optimize);
+	get_pgo_flags(&obj_cmd);
 	nob_cmd_error(&obj_cmd, current_config.error);
 	nob_cmd_include_direction(&obj_cmd, INCLUDE_FOLDER);
 	enum RESULT obj_result = nob_cmd_process_source_dir(
-		&obj_cmd, source_dir, obj_dir, ".c", 
-		current_config.is_debug, is_shared, force_rebuild);
+		graph, &obj_cmd, source_dir, obj_dir, ".c", 
+		current_config.is_debug, is_shared, force_rebuild, &objects, &objects_job);
 
 	if (obj_result == FAILED) {
 		nob_log(NOB_ERROR, nob_temp_sprintf( "Failed building %s.o", plug_name));
@@ -389,39 +750,43 @@ enum RESULT compile_plug(bool force_rebuild, const char *source_dir, const char
 	
 	temp_checkpoint = nob_temp_save();
 	nob_cc(&lib_cmd);
-	nob_cmd_input_objects_dir(&lib_cmd, obj_dir, &file_list);
-	nob_cmd_output_shared_library(&lib_cmd, plug_name, get_target_directory(), current_config.is_debug);
-
-	if (!nob_cmd_run(&lib_cmd)) {
-		nob_log(NOB_ERROR, nob_temp_sprintf( "Failed building %s shared lib", plug_name));
-		assert(false);
-		nob_return_defer(FAILED);
-	}
+	get_pgo_flags(&lib_cmd);
+	nob_cmd_input_files(&lib_cmd, &objects);
+	// Linked next to the plugin and renamed over it, running game can reload it any time
+	// TODO: Windows can't replace a loaded DLL, host needs to load a copy
+	const char *staging_name = nob_temp_sprintf("%s.staging", plug_name);
+	nob_cmd_output_shared_library(&lib_cmd, staging_name, get_target_directory(), current_config.is_debug);
+	const char *staging_path = shared_library_path(staging_name, get_target_directory());
+	size_t lib_job = build_add_staged_artifact_job(graph, shared_library_path(plug_name, get_target_directory()), staging_path, &lib_cmd);
+	build_graph_add_dependency(graph, lib_job, objects_job);
+	build_job_add_inputs(graph, lib_job, &objects);
 
 defer:
 	nob_cmd_free(obj_cmd);
 	nob_cmd_free(lib_cmd);
-	nob_da_free(file_list);
+	nob_da_free(objects);
 	nob_temp_rewind(temp_start);
 	return result;
 }
 
-enum RESULT compile_test_dll(bool force_rebuild) {
+enum RESULT compile_test_dll(struct BuildGraph *graph, bool force_rebuild) {
 	// Reference - https://web.archive.org/web/20201109103748/http://www.mingw.org/wiki/sampledll
 	enum RESULT result = SUCCESS;
 	size_t temp_checkpoint = nob_temp_save();
-	Nob_File_Paths file_list = {0};
+	Nob_File_Paths objects = {0};
 	Nob_Cmd obj_cmd = {0};
 	Nob_Cmd lib_cmd = {0};
+	size_t objects_job;
 
 	bool is_shared = true;
 	nob_cc_flags(&obj_cmd);
 	nob_cmd_optimize(&obj_cmd, current_config.optimize);
+	get_pgo_flags(&obj_cmd);
 	nob_cmd_error(&obj_cmd, current_config.error);
 	nob_cmd_include_direction(&obj_cmd, INCLUDE_FOLDER);
 	enum RESULT obj_result = nob_cmd_process_source_dir(
-		&obj_cmd, "test_dll/", OBJ_FOLDER "test_dll/", ".c", 
-		current_config.is_debug, is_shared, force_rebuild);
+		graph, &obj_cmd, "test_dll/", nob_temp_sprintf("%stest_dll/", get_obj_directory()), ".c", 
+		current_config.is_debug, is_shared, force_rebuild, &objects, &objects_job);
 
 	if (obj_result == FAILED) {
 		nob_log(NOB_ERROR, "Failed building test_dll.o");
@@ -432,65 +797,63 @@ enum RESULT compile_test_dll(bool force_rebuild) {
 
 	temp_checkpoint = nob_temp_save();
 	nob_cc(&lib_cmd);
-	nob_cmd_input_objects_dir(&lib_cmd, OBJ_FOLDER  "test_dll/", &file_list);
+	get_pgo_flags(&lib_cmd);
+	nob_cmd_input_files(&lib_cmd, &objects);
 	nob_cmd_output_shared_library(&lib_cmd, "test_dll", get_target_directory(), current_config.is_debug);
-
-	if (!nob_cmd_run(&lib_cmd)) {
-		nob_log(NOB_ERROR, "Failed building test_dll.a");
-		assert(false);
-		nob_return_defer(FAILED);
-	}
+	size_t lib_job = build_add_artifact_job(graph, shared_library_path("test_dll", get_target_directory()), &lib_cmd);
+	build_graph_add_dependency(graph, lib_job, objects_job);
+	build_job_add_inputs(graph, lib_job, &objects);
 
 defer:
 	nob_cmd_free(obj_cmd);
 	nob_cmd_free(lib_cmd);
-	nob_da_free(file_list);
+	nob_da_free(objects);
 	nob_temp_rewind(temp_checkpoint);
 	return result;
 }
 
-enum RESULT compile_load_library(bool force_rebuild, Nob_Cmd *link_cmd) {
+// Static library `name` from every source of SOURCE_FOLDER `name`/, linked into the main executable
+enum RESULT compile_static_module(struct BuildGraph *graph, bool force_rebuild, const char *name, Nob_Cmd *link_cmd, struct BuildJobIds *link_deps) {
 	enum RESULT result = SUCCESS;
 	size_t temp_checkpoint = nob_temp_save();
-	Nob_File_Paths file_list = {0};
+	Nob_File_Paths objects = {0};
 	Nob_Cmd obj_cmd = {0};
 	Nob_Cmd lib_cmd = {0};
+	size_t objects_job;
 
 	bool is_shared = false;
 
 	// Object files
 	nob_cc_flags(&obj_cmd);
 	nob_cmd_optimize(&obj_cmd, current_config.optimize);
+	get_pgo_flags(&obj_cmd);
 	nob_cmd_error(&obj_cmd, current_config.error);
 	nob_cmd_include_direction(&obj_cmd, INCLUDE_FOLDER);
 	enum RESULT obj_result = nob_cmd_process_source_dir(
-		&obj_cmd, SOURCE_FOLDER "load_library/", OBJ_FOLDER "load_library/", ".c", 
-		current_config.is_debug, is_shared, force_rebuild);
+		graph, &obj_cmd, nob_temp_sprintf("%s%s/", SOURCE_FOLDER, name), nob_temp_sprintf("%s%s/", get_obj_directory(), name), ".c", 
+		current_config.is_debug, is_shared, force_rebuild, &objects, &objects_job);
 
 	if (obj_result == FAILED) {
-		nob_log(NOB_ERROR, "Failed building load_library.o");
+		nob_log(NOB_ERROR, "Failed building %s.o", name);
 		assert(false);
 		nob_return_defer(FAILED);
 	}
-	nob_temp_rewind(temp_checkpoint);
 
 	// static lib
-	temp_checkpoint = nob_temp_save();
-	nob_cmd_new_static_library(&lib_cmd, "load_library", LIB_FOLDER);
-	nob_cmd_input_objects_dir(&lib_cmd, OBJ_FOLDER  "load_library/", &file_list);
-	if (!nob_cmd_run(&lib_cmd)) {
-		nob_log(NOB_ERROR, "Failed building load_library.a");
-		assert(false);
-		nob_return_defer(FAILED);
-	}
+	nob_cmd_new_static_library(&lib_cmd, name, get_lib_directory());
+	nob_cmd_input_files(&lib_cmd, &objects);
+	size_t lib_job = build_add_archive_job(graph, static_library_path(name, get_lib_directory()), &lib_cmd);
+	build_graph_add_dependency(graph, lib_job, objects_job);
+	build_job_add_inputs(graph, lib_job, &objects);
+	nob_da_append(link_deps, lib_job);
 	
-	// NOTE: Can't use temp strings
+	// NOTE: Can't use temp strings, graph owns them until link_cmd is used
 #if defined(_MSC_VER)
-	nob_cmd_append(link_cmd, LIB_FOLDER "load_library.lib");
+	nob_cmd_append(link_cmd, build_graph_strdup(graph, nob_temp_sprintf("%s%s.lib", get_lib_directory(), name)));
 	nob_cmd_append(link_cmd, "Kernel32.lib"); 
 #else
-	nob_cmd_append(link_cmd, "-L" LIB_FOLDER);
-	nob_cmd_append(link_cmd, "-lload_library");
+	nob_cmd_append(link_cmd, build_graph_strdup(graph, nob_temp_sprintf("-L%s", get_lib_directory())));
+	nob_cmd_append(link_cmd, build_graph_strdup(graph, nob_temp_sprintf("-l%s", name)));
 #endif
 
 #if !defined(WINDOWS)
@@ -500,128 +863,30 @@ enum RESULT compile_load_library(bool force_rebuild, Nob_Cmd *link_cmd) {
 defer:
 	nob_cmd_free(obj_cmd);
 	nob_cmd_free(lib_cmd);
-	nob_da_free(file_list);
+	nob_da_free(objects);
 	nob_temp_rewind(temp_checkpoint);
 	return result;
 }
 
-enum RESULT compile_os(bool force_rebuild, Nob_Cmd *link_cmd) {
-	enum RESULT result = SUCCESS;
-	size_t temp_checkpoint = nob_temp_save();
-	Nob_File_Paths file_list = {0};
-	Nob_Cmd obj_cmd = {0};
-	Nob_Cmd lib_cmd = {0};
-
-	bool is_shared = false;
-
-	// Object files
-	nob_cc_flags(&obj_cmd);
-	nob_cmd_optimize(&obj_cmd, current_config.optimize);
-	nob_cmd_error(&obj_cmd, current_config.error);
-	nob_cmd_include_direction(&obj_cmd, INCLUDE_FOLDER);
-	enum RESULT obj_result = nob_cmd_process_source_dir(
-		&obj_cmd, SOURCE_FOLDER "os/", OBJ_FOLDER "os/", ".c", 
-		current_config.is_debug, is_shared, force_rebuild);
-
-	if (obj_result == FAILED) {
-		nob_log(NOB_ERROR, "Failed building os.o");
-		assert(false);
-		nob_return_defer(FAILED);
-	}
-	nob_temp_rewind(temp_checkpoint);
-
-	// static lib
-	temp_checkpoint = nob_temp_save();
-	nob_cmd_new_static_library(&lib_cmd, "os", LIB_FOLDER);
-	nob_cmd_input_objects_dir(&lib_cmd, OBJ_FOLDER  "os/", &file_list);
-	if (!nob_cmd_run(&lib_cmd)) {
-		nob_log(NOB_ERROR, "Failed building os.a");
-		assert(false);
-		nob_return_defer(FAILED);
-	}
-	
-	// NOTE: Can't use temp strings
-#if defined(_MSC_VER)
-	nob_cmd_append(link_cmd, LIB_FOLDER "os.lib");
-	nob_cmd_append(link_cmd, "Kernel32.lib"); 
-#else
-	nob_cmd_append(link_cmd, "-L" LIB_FOLDER);
-	nob_cmd_append(link_cmd, "-los");
-#endif
-
-#if !defined(WINDOWS)
-	nob_cmd_append(link_cmd, "-ldl");
-#endif
-
-defer:
-	nob_cmd_free(obj_cmd);
-	nob_cmd_free(lib_cmd);
-	nob_da_free(file_list);
-	nob_temp_rewind(temp_checkpoint);
-	return result;
+enum RESULT compile_load_library(struct BuildGraph *graph, bool force_rebuild, Nob_Cmd *link_cmd, struct BuildJobIds *link_deps) {
+	return compile_static_module(graph, force_rebuild, "load_library", link_cmd, link_deps);
 }
 
-enum RESULT compile_plug_host(bool force_rebuild, Nob_Cmd *link_cmd) {
-	enum RESULT result = SUCCESS;
-	size_t temp_checkpoint = nob_temp_save();
-	Nob_File_Paths file_list = {0};
-	Nob_Cmd obj_cmd = {0};
-	Nob_Cmd lib_cmd = {0};
-
-	bool is_shared = false;
-
-	// Object files
-	nob_cc_flags(&obj_cmd);
-	nob_cmd_optimize(&obj_cmd, current_config.optimize);
-	nob_cmd_error(&obj_cmd, current_config.error);
-	nob_cmd_include_direction(&obj_cmd, INCLUDE_FOLDER);
-	enum RESULT obj_result = nob_cmd_process_source_dir(
-		&obj_cmd, SOURCE_FOLDER "plug_host/", OBJ_FOLDER "plug_host/", ".c", 
-		current_config.is_debug, is_shared, force_rebuild);
-
-	if (obj_result == FAILED) {
-		nob_log(NOB_ERROR, "Failed building plug_host.o");
-		assert(false);
-		nob_return_defer(FAILED);
-	}
-	nob_temp_rewind(temp_checkpoint);
-
-	// static lib
-	temp_checkpoint = nob_temp_save();
-	nob_cmd_new_static_library(&lib_cmd, "plug_host", LIB_FOLDER);
-	nob_cmd_input_objects_dir(&lib_cmd, OBJ_FOLDER  "plug_host/", &file_list);
-	if (!nob_cmd_run(&lib_cmd)) {
-		nob_log(NOB_ERROR, "Failed building plug_host.a");
-		assert(false);
-		nob_return_defer(FAILED);
-	}
-	
-	// NOTE: Can't use temp strings
-#if _MSC_VER
-	nob_cmd_append(link_cmd, LIB_FOLDER "plug_host.lib");
-	nob_cmd_append(link_cmd, "Kernel32.lib"); 
-#else
-	nob_cmd_append(link_cmd, "-L" LIB_FOLDER);
-	nob_cmd_append(link_cmd, "-lplug_host");
-#endif
-#if !defined(WINDOWS)
-	nob_cmd_append(link_cmd, "-ldl");
-#endif
+enum RESULT compile_os(struct BuildGraph *graph, bool force_rebuild, Nob_Cmd *link_cmd, struct BuildJobIds *link_deps) {
+	return compile_static_module(graph, force_rebuild, "os", link_cmd, link_deps);
+}
 
-defer:
-	nob_cmd_free(obj_cmd);
-	nob_cmd_free(lib_cmd);
-	nob_da_free(file_list);
-	nob_temp_rewind(temp_checkpoint);
-	return result;
+enum RESULT compile_plug_host(struct BuildGraph *graph, bool force_rebuild, Nob_Cmd *link_cmd, struct BuildJobIds *link_deps) {
+	return compile_static_module(graph, force_rebuild, "plug_host", link_cmd, link_deps);
 }
 
-enum RESULT compile_main(bool force_rebuild, Nob_Cmd *link_cmd) {
+enum RESULT compile_main(struct BuildGraph *graph, bool force_rebuild, Nob_Cmd *link_cmd, struct BuildJobIds *link_deps) {
 	enum RESULT result = SUCCESS;
 	size_t temp_checkpoint = nob_temp_save();
-	Nob_File_Paths file_list = {0};
+	Nob_File_Paths objects = {0};
 	Nob_Cmd obj_cmd = {0};
 	Nob_Cmd main_cmd = {0};
+	size_t objects_job;
 	
 	bool is_shared = false;
 	
@@ -630,10 +895,21 @@ enum RESULT compile_main(bool force_rebuild, Nob_Cmd *link_cmd) {
 	nob_cmd_include_direction(&obj_cmd, RAYLIB_SRC_DIR);
 	nob_cmd_include_direction(&obj_cmd, INCLUDE_FOLDER);
 	nob_cmd_optimize(&obj_cmd, current_config.optimize);
+	get_pgo_flags(&obj_cmd);
 	nob_cmd_error(&obj_cmd, current_config.error);
-	enum RESULT obj_result = nob_cmd_process_source_dir(
-		&obj_cmd, SOURCE_FOLDER, OBJ_FOLDER "main/", ".c", 
-		current_config.is_debug, is_shared, force_rebuild);
+	const char *pch_headers[] = {"raylib.h", "adjust.h"};
+	if (build_pch_add_job(graph, &obj_cmd, "main", pch_headers, NOB_ARRAY_LEN(pch_headers), current_config.is_debug, is_shared, force_rebuild) == FAILED) {
+		nob_log(NOB_ERROR, "Failed to set up precompiled header for main");
+		assert(false);
+		nob_return_defer(FAILED);
+	}
+	// Module directories under src/ build their own libraries
+	const char *include[] = {"**/*.c"};
+	const char *exclude[] = {"load_library/**", "os/**", "plug_host/**"};
+	struct SourceGlobs globs = {include, NOB_ARRAY_LEN(include), exclude, NOB_ARRAY_LEN(exclude)};
+	enum RESULT obj_result = nob_cmd_process_source_tree(
+		graph, &obj_cmd, SOURCE_FOLDER, globs, nob_temp_sprintf("%smain/", get_obj_directory()), ".c", 
+		current_config.is_debug, is_shared, force_rebuild, &objects, &objects_job);
 	
 	if (obj_result == FAILED) {
 		nob_log(NOB_ERROR, "Failed building main objects");
@@ -644,86 +920,988 @@ enum RESULT compile_main(bool force_rebuild, Nob_Cmd *link_cmd) {
 	
 
 	nob_cc(&main_cmd);
+	get_pgo_flags(&main_cmd);
 	// Place inside build folder
 	// TODO: move to build/release || build/debug
-	nob_cc_output(&main_cmd, nob_temp_sprintf("%s%s", get_target_directory(), project_name));
+	const char *main_path = nob_temp_sprintf("%s%s", get_target_directory(), project_name);
+	nob_cc_output(&main_cmd, main_path);
 
-	nob_cmd_input_objects_dir(&main_cmd, OBJ_FOLDER  "main/", &file_list);
+	nob_cmd_input_files(&main_cmd, &objects);
 	nob_cmd_append_cmd(&main_cmd, link_cmd);
 	link_raylib(&main_cmd);
-	
-	if (!nob_cmd_run(&main_cmd)) {
-		nob_log(NOB_ERROR, "Failed to compile app");
-		assert(false);
-		nob_return_defer(FAILED);
-	}
+
+	// Linking waits only for own objects and the static libraries
+	size_t main_job = build_add_artifact_job(graph, main_path, &main_cmd);
+	build_graph_add_dependency(graph, main_job, objects_job);
+	build_job_add_inputs(graph, main_job, &objects);
+	build_graph_add_dependencies(graph, main_job, link_deps);
 
 defer:
 	nob_cmd_free(obj_cmd);
 	nob_cmd_free(main_cmd);
-	nob_da_free(file_list);
+	nob_da_free(objects);
 	nob_temp_rewind(temp_checkpoint);
 	return result;
 }
 
-enum RESULT compile_project() {
+// Plan selected modules of current_config, main executable links against its own static libraries
+enum RESULT compile_configuration(struct BuildGraph *graph, Nob_Cmd *link_cmd, struct BuildJobIds *link_deps) {
 	enum RESULT result = SUCCESS;
-	size_t temp_checkpoint = nob_temp_save();
-	// Append only constant commands. Used at the end for main executable to link static libs 
-	Nob_Cmd link_cmd = {0};
-	
-	// TODO: force_rebuild for specific modules through nob arguments
-	bool force_rebuild = false;
-	if (compile_load_library(force_rebuild, &link_cmd) == FAILED) {
-		nob_log(NOB_ERROR, "Failed to compile load_library.");
+	if (target_selected[TARGET_RAYLIB] && compile_raylib(graph, target_rebuild[TARGET_RAYLIB], link_deps) == FAILED) {
+		nob_log(NOB_ERROR, "Failed to compile RAYLIB.");
 		assert(false);
 		nob_return_defer(FAILED);
 	}
 
-	if (compile_os(force_rebuild, &link_cmd) == FAILED) {
-		nob_log(NOB_ERROR, "Failed to compile OS.");
+	if (target_selected[TARGET_LOAD_LIBRARY] && compile_load_library(graph, target_rebuild[TARGET_LOAD_LIBRARY], link_cmd, link_deps) == FAILED) {
+		nob_log(NOB_ERROR, "Failed to compile load_library.");
 		assert(false);
 		nob_return_defer(FAILED);
 	}
 
-	if (compile_plug_host(force_rebuild, &link_cmd) == FAILED) {
-		nob_log(NOB_ERROR, "Failed to compile plug host.");
+	if (target_selected[TARGET_OS] && compile_os(graph, target_rebuild[TARGET_OS], link_cmd, link_deps) == FAILED) {
+		nob_log(NOB_ERROR, "Failed to compile OS.");
 		assert(false);
 		nob_return_defer(FAILED);
 	}
-	
-	if (compile_raylib(force_rebuild, &link_cmd) == FAILED) {
-		nob_log(NOB_ERROR, "Failed to compile RAYLIB.");
+
+	if (target_selected[TARGET_PLUG_HOST] && compile_plug_host(graph, target_rebuild[TARGET_PLUG_HOST], link_cmd, link_deps) == FAILED) {
+		nob_log(NOB_ERROR, "Failed to compile plug host.");
 		assert(false);
 		nob_return_defer(FAILED);
 	}
 
-	if (compile_main(force_rebuild, &link_cmd) == FAILED) {
+	if (target_selected[TARGET_MAIN] && compile_main(graph, target_rebuild[TARGET_MAIN], link_cmd, link_deps) == FAILED) {
 		nob_log(NOB_ERROR, "Failed to compile main module.");
 		assert(false);
 		nob_return_defer(FAILED);
 	}
 
-	if (compile_test_dll(force_rebuild) == FAILED) {
+	if (target_selected[TARGET_TEST_DLL] && compile_test_dll(graph, target_rebuild[TARGET_TEST_DLL]) == FAILED) {
 		nob_log(NOB_ERROR, "Failed to compile test DLL.");
 		assert(false);
 		nob_return_defer(FAILED);
 	}
 
-	if (compile_plug(force_rebuild, "plug_template/", "plug_template") == FAILED) {
+	if (target_selected[TARGET_PLUG_TEMPLATE] && compile_plug(graph, target_rebuild[TARGET_PLUG_TEMPLATE], "plug_template/", "plug_template") == FAILED) {
 		nob_log(NOB_ERROR, "Failed to compile plug template.");
 		assert(false);
 		nob_return_defer(FAILED);
 	}
 
 defer:
+	return result;
+}
+
+enum RESULT compile_project() {
+	enum RESULT result = SUCCESS;
+	size_t temp_checkpoint = nob_temp_save();
+	// Every command of the project, run at the end by one scheduler
+	struct BuildGraph graph = {0};
+	// Append only constant commands. Used at the end for main executable to link static libs 
+	Nob_Cmd link_cmd = {0};
+	// Jobs main executable link waits for
+	struct BuildJobIds link_deps = {0};
+	size_t plan_phase = trace_phase_begin("plan build graph");
+	
+	if (build_db_load(BUILD_FOLDER FINGERPRINTS_FILE_NAME) == FAILED) {
+		nob_log(NOB_ERROR, "Failed to load build fingerprints.");
+		assert(false);
+		nob_return_defer(FAILED);
+	}
+
+	// Every configuration goes to the same graph, so they share process slots
+	for (size_t config = 0; config < build_configs_count; ++config) {
+		use_config(config);
+		link_cmd.count = 0;
+		link_deps.count = 0;
+		if (nob_file_exists(get_obj_directory()) != 1 && !nob_mkdir_if_not_exists(get_obj_directory())) nob_return_defer(FAILED);
+		if (nob_file_exists(get_lib_directory()) != 1 && !nob_mkdir_if_not_exists(get_lib_directory())) nob_return_defer(FAILED);
+		if (compile_configuration(&graph, &link_cmd, &link_deps) == FAILED) nob_return_defer(FAILED);
+	}
+
+	trace_phase_end(plan_phase);
+	size_t run_phase = trace_phase_begin("run build graph");
+	build_snapshot_run_begin();
+	enum RESULT run_result = build_graph_run(&graph, max_jobs);
+	trace_phase_end(run_phase);
+	if (run_result == FAILED) {
+		// Compile errors are not nob's bugs, -watch keeps going after them
+		nob_log(NOB_ERROR, "Failed to build project.");
+		nob_return_defer(FAILED);
+	}
+
+defer:
+	use_config(0);
+	// Whatever got built is recorded, even when the build failed part way
+	trace_add_graph(&graph);
+	build_db_record(&graph);
+	if (build_db_save(BUILD_FOLDER FINGERPRINTS_FILE_NAME) == FAILED) result = FAILED;
+	if (result == SUCCESS) build_snapshot_add_graph(&graph);
+	build_cache_report();
 	nob_temp_rewind(temp_checkpoint);
 	nob_cmd_free(link_cmd);
+	nob_da_free(link_deps);
+	build_graph_free(&graph);
 	return result;
 }
 
-enum RESULT process_cli(int argc, char **argv) {
-	enum RESULT result = SUCCESS;
+//--------------Profile guided optimization-------------------------------------
+static bool pgo__hash_source(Nob_Walk_Entry entry) {
+	if (entry.type != NOB_FILE_REGULAR) return true;
+	Nob_String_View path = nob_sv_from_cstr(entry.path);
+	if (!nob_sv_end_with(path, ".c") && !nob_sv_end_with(path, ".h")) return true;
+	uint64_t hash = hash_cstr(HASH_SEED, entry.path);
+	if (hash_file(&hash, entry.path) == FAILED) return false;
+	// Directory order isn't stable, XOR isn't affected by it
+	*(uint64_t*)entry.data ^= hash;
+	return true;
+}
+
+static bool pgo__hash_profile(Nob_Walk_Entry entry) {
+	if (entry.type != NOB_FILE_REGULAR) return true;
+	Nob_String_View path = nob_sv_from_cstr(entry.path);
+	// GCC reads .gcda next to each object's name, Clang the merged .profdata
+	if (!nob_sv_end_with(path, ".gcda") && !nob_sv_end_with(path, ".profdata")) return true;
+	uint64_t hash = hash_cstr(HASH_SEED, entry.path);
+	if (hash_file(&hash, entry.path) == FAILED) return false;
+	*(uint64_t*)entry.data ^= hash;
+	return true;
+}
+
+// Profile belongs to a configuration and the sources it was trained with.
+// Changed sources get a new directory, profiles of previous ones are deleted.
+enum RESULT set_pgo_directory() {
+	enum RESULT result = SUCCESS;
+	size_t temp_checkpoint = nob_temp_save();
+	Nob_File_Paths children = {0};
+	const char *source_dirs[] = {SOURCE_FOLDER, INCLUDE_FOLDER, "plug_template/", "test_dll/"};
+	uint64_t sources_hash = 0;
+	for (size_t i = 0; i < NOB_ARRAY_LEN(source_dirs); ++i) {
+		if (!nob_walk_dir(source_dirs[i], pgo__hash_source, .data = &sources_hash)) nob_return_defer(FAILED);
+	}
+
+	const char *config_dir = current_config.platform == PLATFORM_WEB ? PGO_FOLDER "web/" :
+		current_config.is_debug ? PGO_FOLDER "debug/" : PGO_FOLDER "release/";
+	if (!nob_mkdir_if_not_exists(PGO_FOLDER)) nob_return_defer(FAILED);
+	if (!nob_mkdir_if_not_exists(config_dir)) nob_return_defer(FAILED);
+	const char *profile_name = nob_temp_sprintf("%016llx", (unsigned long long)sources_hash);
+	if (!nob_read_entire_dir(config_dir, &children)) nob_return_defer(FAILED);
+	for (size_t i = 0; i < children.count; ++i) {
+		const char *child = children.items[i];
+		if (strcmp(child, ".") == 0 || strcmp(child, "..") == 0 || strcmp(child, profile_name) == 0) continue;
+		// Profiles of big projects take a while to delete, the build doesn't need to wait
+		if (delete_directory_background(nob_temp_sprintf("%s%s/", config_dir, child), TRASH_FOLDER) == FAILED) nob_return_defer(FAILED);
+	}
+
+	// Instrumented binaries write profile relative to where they run, so the path is absolute
+	const char *profile_dir = nob_temp_sprintf("%s%s/", config_dir, profile_name);
+	if (!nob_mkdir_if_not_exists(profile_dir)) nob_return_defer(FAILED);
+	snprintf(pgo_dir, sizeof(pgo_dir), "%s/%s", nob_get_current_dir_temp(), profile_dir);
+
+defer:
+	nob_temp_rewind(temp_checkpoint);
+	nob_da_free(children);
+	return result;
+}
+
+// Run instrumented program for PGO_TRAINING_FRAMES frames in a hidden window
+enum RESULT run_pgo_training() {
+	enum RESULT result = SUCCESS;
+	size_t temp_checkpoint = nob_temp_save();
+	Nob_Cmd cmd = {0};
+	char root_dir[1024] = {0};
+	snprintf(root_dir, sizeof(root_dir), "%s", nob_get_current_dir_temp());
+
+	// Program finds plugins and resources relative to its own directory
+	if (!nob_set_current_dir(get_target_directory())) nob_return_defer(FAILED);
+#if defined(_WIN32)
+	_putenv_s("TRAINING_FRAMES", PGO_TRAINING_FRAMES);
+#else
+	setenv("TRAINING_FRAMES", PGO_TRAINING_FRAMES, 1);
+#endif
+	nob_cmd_append(&cmd, nob_temp_sprintf("./%s", project_name));
+	size_t phase = trace_phase_begin("pgo training run");
+	bool trained = nob_cmd_run(&cmd);
+	trace_phase_end(phase);
+#if defined(_WIN32)
+	_putenv_s("TRAINING_FRAMES", "");
+#else
+	unsetenv("TRAINING_FRAMES");
+#endif
+	if (!nob_set_current_dir(root_dir)) nob_return_defer(FAILED);
+	if (!trained) {
+		nob_log(NOB_ERROR, "Training run failed, it needs a display (on headless Linux run nob with xvfb-run)");
+		nob_return_defer(FAILED);
+	}
+
+	// Clang writes raw profiles that need merging, whatever compiler built nob
+	if (cc_family() == CC_FAMILY_CLANG) {
+		Nob_File_Paths raw_profiles = {0};
+		if (nob_fetch_files(pgo_dir, &raw_profiles, ".profraw") == FAILED) nob_return_defer(FAILED);
+		nob_cmd_append(&cmd, "llvm-profdata", "merge", nob_temp_sprintf("-output=%sdefault.profdata", pgo_dir));
+		for (size_t i = 0; i < raw_profiles.count; ++i) {
+			nob_cmd_append(&cmd, nob_temp_sprintf("%s%s", pgo_dir, raw_profiles.items[i]));
+		}
+		nob_da_free(raw_profiles);
+		if (!nob_cmd_run(&cmd)) nob_return_defer(FAILED);
+	}
+
+defer:
+	nob_cmd_free(cmd);
+	nob_temp_rewind(temp_checkpoint);
+	return result;
+}
+
+// -optimize pgo: without profile for current sources build instrumented and train,
+// then build using the profile
+enum RESULT compile_pgo() {
+	enum RESULT result = SUCCESS;
+	size_t temp_checkpoint = nob_temp_save();
+	if (set_pgo_directory() == FAILED) {
+		nob_log(NOB_ERROR, "Failed to set up profile directory.");
+		assert(false);
+		nob_return_defer(FAILED);
+	}
+
+	const char *trained_path = nob_temp_sprintf("%s%s", pgo_dir, PGO_TRAINED_FILE_NAME);
+	if (nob_file_exists(trained_path) != 1) {
+		nob_log(NOB_INFO, "No profile for current sources, building instrumented binaries");
+		pgo_stage = PGO_GENERATE;
+		if (compile_project() == FAILED) {
+			nob_log(NOB_ERROR, "Failed to build instrumented project.");
+			assert(false);
+			nob_return_defer(FAILED);
+		}
+		if (run_pgo_training() == FAILED) {
+			nob_log(NOB_ERROR, "Failed to train profile.");
+			nob_return_defer(FAILED);
+		}
+		if (!nob_write_entire_file(trained_path, NULL, 0)) nob_return_defer(FAILED);
+	}
+
+	// Retraining rewrites the profile in the same directory
+	pgo_profile_hash = 0;
+	if (!nob_walk_dir(pgo_dir, pgo__hash_profile, .data = &pgo_profile_hash)) nob_return_defer(FAILED);
+	pgo_stage = PGO_USE;
+	if (compile_project() == FAILED) {
+		nob_log(NOB_ERROR, "Failed to build project with profile.");
+		assert(false);
+		nob_return_defer(FAILED);
+	}
+
+defer:
+	nob_temp_rewind(temp_checkpoint);
+	return result;
+}
+
+// Write build/trace.json and print the summary of everything since trace_start()
+void finish_trace() {
+	// No-op builds exit before tracing anything, keep the last real trace
+	if (build_trace.start_ns == 0) return;
+	if (nob_file_exists(BUILD_FOLDER) == 1 && trace_write(BUILD_FOLDER TRACE_FILE_NAME) == FAILED) {
+		nob_log(NOB_WARNING, "Failed to write build trace");
+	}
+	trace_report();
+	trace_free();
+}
+
+//--------------No-op snapshot--------------------------------------------------
+static uint64_t snapshot_key = 0;
+
+// Arguments pick configuration and flags, different ones need a real build
+void set_snapshot_key(int argc, char **argv) {
+	snapshot_key = hash_cstr(HASH_SEED, PROJECT_NAME);
+	for (int i = 0; i < argc; ++i) {
+		// Daemon serves clients started without it
+		if (strcmp(argv[i], "-daemon") == 0) continue;
+		snapshot_key = hash_cstr(snapshot_key, argv[i]);
+	}
+}
+
+static bool snapshot__add_entry(Nob_Walk_Entry entry) {
+	build_snapshot_add(entry.path);
+	return true;
+}
+
+// After a successful build remember everything it depended on, so the next identical run can exit early
+void save_snapshot(enum RESULT build_result) {
+	// Same -rebuild again has to compile again
+	if (build_result == SUCCESS && !rebuild_forced) {
+		size_t temp_checkpoint = nob_temp_save();
+		// Resources and nob itself, raylib and project sources were added while planning
+		if (nob_file_exists(RESOURCES_FOLDER) == 1) nob_walk_dir(RESOURCES_FOLDER, snapshot__add_entry);
+		for (size_t i = 0; i < build_configs_count; ++i) {
+			use_config(i);
+			if (get_target_resources_directory() != NULL) build_snapshot_add(get_target_resources_directory());
+		}
+		use_config(0);
+		// Profile contents change without changing its directory
+		if (use_pgo) nob_walk_dir(pgo_dir, snapshot__add_entry);
+		const char *nob_path = nob_temp_running_executable_path();
+		if (nob_path[0] != '\0') build_snapshot_add(nob_path);
+		build_snapshot_add_output(BUILD_FOLDER FINGERPRINTS_FILE_NAME);
+		nob_temp_rewind(temp_checkpoint);
+		if (build_snapshot_save(BUILD_FOLDER SNAPSHOT_FILE_NAME, snapshot_key) == FAILED) {
+			nob_log(NOB_WARNING, "Failed to save build snapshot, next build can't skip planning");
+		}
+	}
+	build_snapshot_free();
+}
+
+//--------------Benchmarks------------------------------------------------------
+// What nob_copy_file() falls back to, 32 KiB through userspace
+static bool bench__copy_buffered(const char *src_path, const char *dst_path) {
+	bool result = true;
+	char buffer[32*1024];
+	FILE *src = fopen(src_path, "rb");
+	FILE *dst = fopen(dst_path, "wb");
+	if (src == NULL || dst == NULL) nob_return_defer(false);
+	for (;;) {
+		size_t n = fread(buffer, 1, sizeof(buffer), src);
+		if (n == 0) break;
+		if (fwrite(buffer, 1, n, dst) != n) nob_return_defer(false);
+	}
+	if (ferror(src)) result = false;
+
+defer:
+	if (src != NULL) fclose(src);
+	if (dst != NULL) fclose(dst);
+	return result;
+}
+
+// Best of BENCH_COPY_RUNS in MiB/s, destination is deleted before every run
+static double bench__copy_throughput(bool (*copy)(const char*, const char*), const char *src_path, const char *dst_path, size_t size_mib) {
+	uint64_t best_ns = UINT64_MAX;
+	for (int i = 0; i < BENCH_COPY_RUNS; ++i) {
+		if (nob_file_exists(dst_path) == 1) nob_delete_file(dst_path);
+		uint64_t start = nob_nanos_since_unspecified_epoch();
+		if (!copy(src_path, dst_path)) return 0.0;
+		uint64_t elapsed = nob_nanos_since_unspecified_epoch() - start;
+		if (elapsed < best_ns) best_ns = elapsed;
+	}
+	return size_mib / (best_ns / 1e9);
+}
+
+// Throughput of nob_copy_file() against a plain buffered copy, both from page cache.
+// On a reflink filesystem nob_copy_file() doesn't copy data at all.
+enum RESULT bench_copy_file(size_t size_mib) {
+	enum RESULT result = SUCCESS;
+	const char *src_path = BENCH_FOLDER "copy_src.bin";
+	const char *dst_path = BENCH_FOLDER "copy_dst.bin";
+	Nob_Log_Level log_level = nob_minimal_log_level;
+	char *chunk = NULL;
+	FILE *src = NULL;
+	if (!nob_mkdir_if_not_exists(BUILD_FOLDER) || !nob_mkdir_if_not_exists(BENCH_FOLDER)) nob_return_defer(FAILED);
+
+	// Incompressible content, compressing filesystems can't cheat with it
+	size_t chunk_size = 1024*1024;
+	chunk = (char*)malloc(chunk_size);
+	NOB_ASSERT(chunk != NULL && "Buy more RAM lol");
+	uint64_t state = HASH_SEED;
+	for (size_t i = 0; i < chunk_size; ++i) {
+		state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+		chunk[i] = (char)(state >> 56);
+	}
+	src = fopen(src_path, "wb");
+	if (src == NULL) nob_return_defer(FAILED);
+	for (size_t i = 0; i < size_mib; ++i) {
+		// Chunks differ, deduplicating filesystems can't cheat either
+		chunk[i % chunk_size] ^= (char)(i + 1);
+		if (fwrite(chunk, 1, chunk_size, src) != chunk_size) nob_return_defer(FAILED);
+	}
+	fclose(src);
+	src = NULL;
+
+	nob_log(NOB_INFO, "Copying %zu MiB file, best of %d runs", size_mib, BENCH_COPY_RUNS);
+	// nob_copy_file() logs every copy
+	nob_minimal_log_level = NOB_WARNING;
+	double buffered = bench__copy_throughput(bench__copy_buffered, src_path, dst_path, size_mib);
+	double zero_copy = bench__copy_throughput(nob_copy_file, src_path, dst_path, size_mib);
+	nob_minimal_log_level = log_level;
+	if (buffered == 0.0 || zero_copy == 0.0) {
+		nob_log(NOB_ERROR, "Copy benchmark failed");
+		nob_return_defer(FAILED);
+	}
+	nob_log(NOB_INFO, "  buffered 32 KiB: %10.0f MiB/s", buffered);
+	nob_log(NOB_INFO, "  nob_copy_file:   %10.0f MiB/s (%.1fx)", zero_copy, zero_copy / buffered);
+
+defer:
+	if (src != NULL) fclose(src);
+	free(chunk);
+	nob_minimal_log_level = NOB_WARNING;
+	if (nob_file_exists(src_path) == 1) nob_delete_file(src_path);
+	if (nob_file_exists(dst_path) == 1) nob_delete_file(dst_path);
+	nob_minimal_log_level = log_level;
+	return result;
+}
+
+//--------------Build benchmark-------------------------------------------------
+struct BenchResult {
+	const char *scenario;
+	double ms;
+	size_t jobs;                    // Commands that ran
+	size_t checked;                 // Files the snapshot check stat'ed
+	size_t temp_peak;               // nob_temp_high_water() after the scenario
+};
+
+static uint64_t bench__random(uint64_t *state) {
+	*state = *state * 6364136223846793005ULL + 1442695040888963407ULL;
+	return *state >> 33;
+}
+
+// Headers include only lower numbered ones, so the include graph has no cycles
+static void bench__append_includes(Nob_String_Builder *sb, uint64_t *state, size_t below) {
+	for (size_t i = 0; i < bench_shape.fanout && below > 0; ++i) {
+		nob_sb_appendf(sb, "#include \"h%03zu.h\"\n", (size_t)(bench__random(state) % below));
+	}
+}
+
+static enum RESULT bench__write_project() {
+	enum RESULT result = SUCCESS;
+	Nob_String_Builder sb = {0};
+	size_t temp_checkpoint = nob_temp_save();
+	uint64_t state = HASH_SEED;
+	if (!nob_mkdir_if_not_exists(INCLUDE_FOLDER) || !nob_mkdir_if_not_exists(SOURCE_FOLDER)) nob_return_defer(FAILED);
+
+	for (size_t i = 0; i < bench_shape.headers; ++i) {
+		sb.count = 0;
+		nob_sb_appendf(&sb, "#pragma once\n");
+		bench__append_includes(&sb, &state, i);
+		nob_sb_appendf(&sb, "typedef struct { int a, b; float c[4]; } H%03zu;\n", i);
+		nob_sb_appendf(&sb, "static inline int h%03zu(int x) { H%03zu h = {x, x * %zu, {0}}; return h.a + h.b; }\n", i, i, i + 1);
+		if (!nob_write_entire_file(nob_temp_sprintf("%sh%03zu.h", INCLUDE_FOLDER, i), sb.items, sb.count)) nob_return_defer(FAILED);
+	}
+
+	size_t directories = bench_shape.modules + bench_shape.plugins;
+	for (size_t d = 0; d < directories; ++d) {
+		bool is_plugin = d >= bench_shape.modules;
+		const char *dir = is_plugin ? nob_temp_sprintf("plug%02zu/", d - bench_shape.modules) : nob_temp_sprintf("%smod%02zu/", SOURCE_FOLDER, d);
+		size_t files = is_plugin ? (bench_shape.files + 1) / 2 : bench_shape.files;
+		if (!nob_mkdir_if_not_exists(dir)) nob_return_defer(FAILED);
+		for (size_t f = 0; f < files; ++f) {
+			sb.count = 0;
+			bench__append_includes(&sb, &state, bench_shape.headers);
+			nob_sb_appendf(&sb, "int d%02zu_f%03zu(int x) { return x + %zu; }\n", d, f, f);
+			if (!nob_write_entire_file(nob_temp_sprintf("%sf%03zu.c", dir, f), sb.items, sb.count)) nob_return_defer(FAILED);
+		}
+	}
+	sb.count = 0;
+	nob_sb_appendf(&sb, "#include \"h%03zu.h\"\nint main(void) { return h%03zu(0); }\n", bench_shape.headers - 1, bench_shape.headers - 1);
+	if (!nob_write_entire_file(SOURCE_FOLDER "main.c", sb.items, sb.count)) nob_return_defer(FAILED);
+
+defer:
+	nob_temp_rewind(temp_checkpoint);
+	nob_sb_free(sb);
+	return result;
+}
+
+// Plan and run the synthetic project like compile_project() does, `jobs` gets the commands that ran
+static enum RESULT bench__build(bool record_snapshot, size_t *jobs) {
+	enum RESULT result = SUCCESS;
+	size_t temp_checkpoint = nob_temp_save();
+	struct BuildGraph graph = {0};
+	Nob_Cmd link_cmd = {0};
+	Nob_Cmd obj_cmd = {0};
+	Nob_Cmd main_cmd = {0};
+	struct BuildJobIds link_deps = {0};
+	Nob_File_Paths objects = {0};
+	size_t objects_job;
+	if (build_db_load(BUILD_FOLDER FINGERPRINTS_FILE_NAME) == FAILED) nob_return_defer(FAILED);
+	if (mkdir_parents(get_obj_directory()) == FAILED || mkdir_parents(get_lib_directory()) == FAILED) nob_return_defer(FAILED);
+	if (mkdir_parents(get_target_directory()) == FAILED) nob_return_defer(FAILED);
+
+	for (size_t i = 0; i < bench_shape.modules; ++i) {
+		if (compile_static_module(&graph, false, nob_temp_sprintf("mod%02zu", i), &link_cmd, &link_deps) == FAILED) nob_return_defer(FAILED);
+	}
+	for (size_t i = 0; i < bench_shape.plugins; ++i) {
+		if (compile_plug(&graph, false, nob_temp_sprintf("plug%02zu/", i), nob_temp_sprintf("plug%02zu", i)) == FAILED) nob_return_defer(FAILED);
+	}
+
+	// Main gets a precompiled header of the top headers, like compile_main()
+	Nob_File_Paths main_source = {0};
+	nob_da_append(&main_source, "main.c");
+	nob_cc_flags(&obj_cmd);
+	nob_cmd_include_direction(&obj_cmd, INCLUDE_FOLDER);
+	nob_cmd_optimize(&obj_cmd, current_config.optimize);
+	nob_cmd_error(&obj_cmd, current_config.error);
+	const char *pch_headers[] = {
+		nob_temp_sprintf("h%03zu.h", bench_shape.headers - 1),
+		nob_temp_sprintf("h%03zu.h", bench_shape.headers > 1 ? bench_shape.headers - 2 : 0),
+	};
+	if (build_pch_add_job(&graph, &obj_cmd, "bench", pch_headers, NOB_ARRAY_LEN(pch_headers), current_config.is_debug, false, false) == FAILED) {
+		nob_da_free(main_source);
+		nob_return_defer(FAILED);
+	}
+	enum RESULT main_result = nob_cmd_process_source_files(&graph, &obj_cmd, SOURCE_FOLDER, &main_source, get_obj_directory(), ".c",
+		current_config.is_debug, false, false, &objects, &objects_job);
+	nob_da_free(main_source);
+	if (main_result == FAILED) nob_return_defer(FAILED);
+	const char *main_path = nob_temp_sprintf("%sbench", get_target_directory());
+	nob_cc(&main_cmd);
+	nob_cc_output(&main_cmd, main_path);
+	nob_cmd_input_files(&main_cmd, &objects);
+	nob_cmd_append_cmd(&main_cmd, &link_cmd);
+	size_t main_job = build_add_artifact_job(&graph, main_path, &main_cmd);
+	build_graph_add_dependency(&graph, main_job, objects_job);
+	build_job_add_inputs(&graph, main_job, &objects);
+	build_graph_add_dependencies(&graph, main_job, &link_deps);
+
+	build_snapshot_run_begin();
+	if (build_graph_run(&graph, max_jobs) == FAILED) nob_return_defer(FAILED);
+
+defer:
+	*jobs = graph.spans.count;
+	build_db_record(&graph);
+	if (build_db_save(BUILD_FOLDER FINGERPRINTS_FILE_NAME) == FAILED) result = FAILED;
+	if (result == SUCCESS && record_snapshot) {
+		build_snapshot_add_graph(&graph);
+		if (build_snapshot_save(BUILD_FOLDER SNAPSHOT_FILE_NAME, snapshot_key) == FAILED) result = FAILED;
+	}
+	build_snapshot_free();
+	nob_temp_rewind(temp_checkpoint);
+	nob_cmd_free(link_cmd);
+	nob_cmd_free(obj_cmd);
+	nob_cmd_free(main_cmd);
+	nob_da_free(link_deps);
+	nob_da_free(objects);
+	build_graph_free(&graph);
+	return result;
+}
+
+// Build after making `path` newer than everything built from it, then give it back its old time,
+// so later scenarios see an up to date tree again
+static enum RESULT bench__touch_build(const char *path, size_t *jobs) {
+	struct FileStat before = {0};
+	if (!file_stat(path, &before)) return FAILED;
+	// nob_needs_rebuild() compares whole seconds
+	uint64_t now = (uint64_t)time(NULL) * 1000000000ULL;
+	if (!file__set_mtime(path, now + 2000000000ULL)) return FAILED;
+	enum RESULT result = bench__build(false, jobs);
+	if (!file__set_mtime(path, before.mtime_ns)) return FAILED;
+	return result;
+}
+
+static void bench__write_results(struct BenchResult *results, size_t count, size_t sources) {
+	Nob_String_Builder csv = {0};
+	Nob_String_Builder json = {0};
+	nob_sb_appendf(&csv, "scenario,modules,files,headers,fanout,plugins,sources,ms,jobs,checked,temp_peak_kib\n");
+	nob_sb_appendf(&json, "{\"shape\":{\"modules\":%zu,\"files\":%zu,\"headers\":%zu,\"fanout\":%zu,\"plugins\":%zu,\"sources\":%zu},\"results\":[",
+		bench_shape.modules, bench_shape.files, bench_shape.headers, bench_shape.fanout, bench_shape.plugins, sources);
+	for (size_t i = 0; i < count; ++i) {
+		struct BenchResult *r = &results[i];
+		nob_sb_appendf(&csv, "%s,%zu,%zu,%zu,%zu,%zu,%zu,%.3f,%zu,%zu,%zu\n", r->scenario,
+			bench_shape.modules, bench_shape.files, bench_shape.headers, bench_shape.fanout, bench_shape.plugins, sources,
+			r->ms, r->jobs, r->checked, r->temp_peak / 1024);
+		nob_sb_appendf(&json, "%s\n{\"scenario\":\"%s\",\"ms\":%.3f,\"jobs\":%zu,\"checked\":%zu,\"temp_peak_kib\":%zu}",
+			i > 0 ? "," : "", r->scenario, r->ms, r->jobs, r->checked, r->temp_peak / 1024);
+	}
+	nob_sb_appendf(&json, "\n]}\n");
+	if (!nob_write_entire_file(BENCH_FOLDER BENCH_RESULTS_NAME ".csv", csv.items, csv.count) ||
+		!nob_write_entire_file(BENCH_FOLDER BENCH_RESULTS_NAME ".json", json.items, json.count)) {
+		nob_log(NOB_WARNING, "Failed to write benchmark results");
+	}
+	nob_sb_free(csv);
+	nob_sb_free(json);
+}
+
+// -bench-build: generate a project shaped like this one and time cold, no-op, one source touched and
+// one header touched builds through the same module, cache, precompiled header and graph code. Results go to
+// build/bench/build_results.csv and .json, each scenario uses its own freshly loaded fingerprints.
+enum RESULT bench_build() {
+	enum RESULT result = SUCCESS;
+	struct BenchResult results[5] = {0};
+	size_t results_count = 0;
+	Nob_Log_Level log_level = nob_minimal_log_level;
+	size_t sources = bench_shape.modules * bench_shape.files + bench_shape.plugins * ((bench_shape.files + 1) / 2) + 1;
+	char root_dir[1024] = {0};
+	snprintf(root_dir, sizeof(root_dir), "%s", nob_get_current_dir_temp());
+	bool entered = false;
+	nob_log(NOB_INFO, "Benchmark project: %zu modules x %zu files, %zu headers including %zu each, %zu plugins (%zu sources)",
+		bench_shape.modules, bench_shape.files, bench_shape.headers, bench_shape.fanout, bench_shape.plugins, sources);
+	if (jobserver_init(max_jobs) == FAILED) nob_return_defer(FAILED);
+	// Directories and commands log every line
+	nob_minimal_log_level = NOB_WARNING;
+	if (mkdir_parents(BENCH_PROJECT_FOLDER) == FAILED) nob_return_defer(FAILED);
+	if (delete_directory(BENCH_PROJECT_FOLDER) == FAILED || !nob_mkdir_if_not_exists(BENCH_PROJECT_FOLDER)) nob_return_defer(FAILED);
+	if (!nob_set_current_dir(BENCH_PROJECT_FOLDER)) nob_return_defer(FAILED);
+	entered = true;
+	// Same object cache and precompiled header settings as a real build, cache starts empty
+	if (setup_build_cache() == FAILED) nob_return_defer(FAILED);
+	if (bench__write_project() == FAILED) nob_return_defer(FAILED);
+
+	const char *scenarios[] = {"cold", "noop_snapshot", "noop", "touch_source", "touch_header"};
+	for (size_t i = 0; i < NOB_ARRAY_LEN(scenarios); ++i) {
+		struct BenchResult *r = &results[results_count++];
+		r->scenario = scenarios[i];
+		// Every run starts like a new nob process
+		build_db_free();
+		uint64_t start = nob_nanos_since_unspecified_epoch();
+		enum RESULT run_result = SUCCESS;
+		switch (i) {
+			case 0: run_result = bench__build(true, &r->jobs); break;
+			case 1: if (!build_snapshot_unchanged(BUILD_FOLDER SNAPSHOT_FILE_NAME, snapshot_key, &r->checked)) run_result = FAILED; break;
+			case 2: run_result = bench__build(false, &r->jobs); break;
+			case 3: run_result = bench__touch_build(SOURCE_FOLDER "mod00/f000.c", &r->jobs); break;
+			// Lowest header is included by the most others
+			case 4: run_result = bench__touch_build(INCLUDE_FOLDER "h000.h", &r->jobs); break;
+		}
+		r->ms = (nob_nanos_since_unspecified_epoch() - start) / 1e6;
+		r->temp_peak = nob_temp_high_water();
+		if (run_result == FAILED) {
+			nob_minimal_log_level = log_level;
+			nob_log(NOB_ERROR, "Benchmark scenario %s failed", r->scenario);
+			nob_return_defer(FAILED);
+		}
+	}
+	nob_minimal_log_level = log_level;
+
+	nob_log(NOB_INFO, "  %-14s %10s %6s %8s %10s", "scenario", "ms", "jobs", "checked", "temp KiB");
+	for (size_t i = 0; i < results_count; ++i) {
+		nob_log(NOB_INFO, "  %-14s %10.2f %6zu %8zu %10zu", results[i].scenario, results[i].ms, results[i].jobs, results[i].checked, results[i].temp_peak / 1024);
+	}
+
+defer:
+	nob_minimal_log_level = log_level;
+	build_db_free();
+	if (entered) nob_set_current_dir(root_dir);
+	if (result == SUCCESS) {
+		bench__write_results(results, results_count, sources);
+		nob_log(NOB_INFO, "Results in " BENCH_FOLDER BENCH_RESULTS_NAME ".csv and .json");
+	}
+	return result;
+}
+
+//--------------Watch-----------------------------------------------------------
+#if defined(LINUX)
+struct Watch {
+	int fd;
+	Nob_File_Paths dirs;            // Indexed by watch descriptor, owned
+	size_t resources_first;         // Watch descriptors from here on are resources
+};
+
+static bool watch__add_dir(Nob_Walk_Entry entry) {
+	if (entry.type != NOB_FILE_DIRECTORY) return true;
+	struct Watch *w = (struct Watch*)entry.data;
+	// IN_ATTRIB catches `touch`, the memo keeps stats until a change is reported
+	int wd = inotify_add_watch(w->fd, entry.path, IN_CLOSE_WRITE | IN_ATTRIB | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO);
+	if (wd < 0) {
+		nob_log(NOB_ERROR, "Failed to watch %s: %s", entry.path, strerror(errno));
+		return false;
+	}
+	build_memo_watch_dir(entry.path);
+	while (w->dirs.count <= (size_t)wd) nob_da_append(&w->dirs, NULL);
+	if (w->dirs.items[wd] == NULL) w->dirs.items[wd] = strdup(entry.path);
+	return true;
+}
+
+// Read pending events, tell if sources or resources changed. Editor temp files don't count.
+static enum RESULT watch__read(struct Watch *w, bool *sources_changed, bool *resources_changed) {
+	char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+	ssize_t size = read(w->fd, buffer, sizeof(buffer));
+	if (size < 0) {
+		if (errno == EINTR || errno == EAGAIN) return SUCCESS;
+		nob_log(NOB_ERROR, "Failed to read file changes: %s", strerror(errno));
+		return FAILED;
+	}
+	for (char *it = buffer; it < buffer + size; ) {
+		struct inotify_event *event = (struct inotify_event*)it;
+		it += sizeof(*event) + event->len;
+		if (event->wd < 0 || (size_t)event->wd >= w->dirs.count || event->len == 0) continue;
+		const char *dir = w->dirs.items[event->wd];
+		bool is_resource = (size_t)event->wd >= w->resources_first;
+		// New directories are watched too
+		if ((event->mask & IN_ISDIR) && (event->mask & (IN_CREATE | IN_MOVED_TO))) {
+			const char *path = nob_temp_sprintf("%s/%s", dir, event->name);
+			if (!nob_walk_dir(path, watch__add_dir, .data = w)) return FAILED;
+		}
+		if (is_resource) {
+			*resources_changed = true;
+			continue;
+		}
+		// Moved directory takes its files along without reporting them
+		build_memo_forget((event->mask & IN_ISDIR) ? NULL : nob_temp_sprintf("%s/%s", dir, event->name));
+		Nob_String_View name = nob_sv_from_cstr(event->name);
+		if (nob_sv_end_with(name, ".c") || nob_sv_end_with(name, ".h") || (event->mask & IN_ISDIR)) *sources_changed = true;
+	}
+	return SUCCESS;
+}
+
+// Sources, headers and resources of every module. Builds until watch_close() go through the memo.
+static enum RESULT watch_open(struct Watch *w) {
+	const char *source_dirs[] = {SOURCE_FOLDER, INCLUDE_FOLDER, "plug_template/", "test_dll/"};
+	build_memo_enable();
+	w->fd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+	if (w->fd < 0) {
+		nob_log(NOB_ERROR, "Failed to start watching: %s", strerror(errno));
+		return FAILED;
+	}
+	for (size_t i = 0; i < NOB_ARRAY_LEN(source_dirs); ++i) {
+		if (!nob_walk_dir(source_dirs[i], watch__add_dir, .data = w)) return FAILED;
+	}
+	w->resources_first = w->dirs.count;
+	if (nob_file_exists(RESOURCES_FOLDER) == 1 && !nob_walk_dir(RESOURCES_FOLDER, watch__add_dir, .data = w)) return FAILED;
+	return SUCCESS;
+}
+
+static void watch_close(struct Watch *w) {
+	if (w->fd >= 0) close(w->fd);
+	for (size_t i = 0; i < w->dirs.count; ++i) free((void*)w->dirs.items[i]);
+	nob_da_free(w->dirs);
+	build_memo_free();
+}
+#endif
+
+// -watch: rebuild when sources, headers or resources change. Fingerprints and depfiles
+// decide what is affected, so a plugin edit relinks only the plugin.
+enum RESULT watch_project() {
+	enum RESULT result = SUCCESS;
+#if defined(LINUX)
+	struct Watch w = {0};
+	if (watch_open(&w) == FAILED) nob_return_defer(FAILED);
+
+	nob_log(NOB_INFO, "Watching for changes, Ctrl+C to stop");
+	for (;;) {
+		bool sources_changed = false;
+		bool resources_changed = false;
+		size_t temp_checkpoint = nob_temp_save();
+		struct pollfd pfd = {w.fd, POLLIN, 0};
+		if (poll(&pfd, 1, -1) < 0 && errno != EINTR) nob_return_defer(FAILED);
+		if (watch__read(&w, &sources_changed, &resources_changed) == FAILED) nob_return_defer(FAILED);
+		// Editors save in bursts (temp file, rename, chmod), wait until it settles
+		while (poll(&pfd, 1, WATCH_DEBOUNCE_MS) > 0) {
+			if (watch__read(&w, &sources_changed, &resources_changed) == FAILED) nob_return_defer(FAILED);
+		}
+		nob_temp_rewind(temp_checkpoint);
+		if (!sources_changed && !resources_changed) continue;
+
+		trace_start();
+		if (resources_changed && setup_resources() == FAILED) {
+			nob_log(NOB_ERROR, "Failed to update resources");
+		}
+		// Failed build keeps watching, next save may fix it
+		if (sources_changed) {
+			enum RESULT build_result = compile_project();
+			if (build_result == FAILED) nob_log(NOB_ERROR, "Build failed");
+			save_snapshot(build_result);
+		}
+		finish_trace();
+		nob_log(NOB_INFO, "Watching for changes, Ctrl+C to stop");
+	}
+
+defer:
+	watch_close(&w);
+#else
+	// TODO: ReadDirectoryChangesW on Windows, FSEvents on macOS
+	nob_log(NOB_ERROR, "-watch is only supported on Linux for now");
+	nob_return_defer(FAILED);
+defer:
+#endif
+	return result;
+}
+
+//--------------Daemon----------------------------------------------------------
+// Client sends magic and snapshot_key, daemon streams the build log and ends with '\0' and a reply
+enum DAEMON_REPLY {
+	DAEMON_OK = '0',
+	DAEMON_FAILED = '1',
+	DAEMON_MISMATCH = 'M',       // Started with other arguments, client builds itself
+	DAEMON_STALE = 'S',          // nob was rebuilt since the daemon started, daemon exits
+	DAEMON_UNAVAILABLE = 'U',    // Not running, client side only
+};
+
+#if defined(LINUX)
+static int daemon__socket(struct sockaddr_un *address) {
+	memset(address, 0, sizeof(*address));
+	address->sun_family = AF_UNIX;
+	// Relative to root_dir, absolute paths can outgrow sun_path
+	snprintf(address->sun_path, sizeof(address->sun_path), "%s", BUILD_FOLDER DAEMON_SOCKET_NAME);
+	return socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+}
+
+static enum DAEMON_REPLY daemon__build(int client, bool *sources_dirty, bool *resources_dirty) {
+	uint64_t start = nob_nanos_since_unspecified_epoch();
+	// A client with other arguments builds locally into the same outputs, inotify doesn't see build/.
+	// Snapshot of the daemon's last build tells if what's on disk is still its own.
+	size_t snapshot_checked = 0;
+	if (!build_snapshot_unchanged(BUILD_FOLDER SNAPSHOT_FILE_NAME, snapshot_key, &snapshot_checked)) {
+		*sources_dirty = true;
+		*resources_dirty = true;
+	}
+	if (!*sources_dirty && !*resources_dirty) {
+		dprintf(client, "[INFO] Nothing changed, daemon answered in %.3f ms\n", (nob_nanos_since_unspecified_epoch() - start) / 1e6);
+		return DAEMON_OK;
+	}
+
+	// Log and compiler output of this build go to the client
+	fflush(stdout);
+	fflush(stderr);
+	int saved_stdout = dup(STDOUT_FILENO);
+	int saved_stderr = dup(STDERR_FILENO);
+	dup2(client, STDOUT_FILENO);
+	dup2(client, STDERR_FILENO);
+
+	enum RESULT result = SUCCESS;
+	trace_start();
+	if (*resources_dirty && setup_resources() == FAILED) result = FAILED;
+	else *resources_dirty = false;
+	if (*sources_dirty) {
+		// Fingerprints and parsed depfiles stay loaded, build_db_load() and the memo notice a local build's rewrites
+		enum RESULT build_result = compile_project();
+		save_snapshot(build_result);
+		// Failed build is tried again on the next request
+		if (build_result == SUCCESS) *sources_dirty = false;
+		else result = FAILED;
+	}
+	finish_trace();
+
+	fflush(stdout);
+	fflush(stderr);
+	dup2(saved_stdout, STDOUT_FILENO);
+	dup2(saved_stderr, STDERR_FILENO);
+	close(saved_stdout);
+	close(saved_stderr);
+	nob_log(NOB_INFO, "Served %s build in %.2f ms", result == SUCCESS ? "a" : "a failed", (nob_nanos_since_unspecified_epoch() - start) / 1e6);
+	return result == SUCCESS ? DAEMON_OK : DAEMON_FAILED;
+}
+#endif
+
+// -daemon: stay resident and answer build requests of ./nob clients.
+// Changes seen through inotify and the no-op snapshot decide if a request builds at all.
+enum RESULT serve_daemon() {
+	enum RESULT result = SUCCESS;
+#if defined(LINUX)
+	struct Watch w = {0};
+	struct sockaddr_un address;
+	int server = daemon__socket(&address);
+	// Edits made during the first build weren't watched yet
+	bool sources_dirty = true;
+	bool resources_dirty = true;
+	struct FileStat executable = {0};
+	const char *executable_path = nob_temp_running_executable_path();
+	if (server < 0 || !file_stat(executable_path, &executable)) nob_return_defer(FAILED);
+	executable_path = strdup(executable_path);
+	if (watch_open(&w) == FAILED) nob_return_defer(FAILED);
+
+	// Left over by a killed daemon
+	unlink(address.sun_path);
+	if (bind(server, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(server, 16) != 0) {
+		nob_log(NOB_ERROR, "Failed to listen on %s: %s", address.sun_path, strerror(errno));
+		nob_return_defer(FAILED);
+	}
+	// Client going away mid build must not kill the daemon
+	signal(SIGPIPE, SIG_IGN);
+	nob_log(NOB_INFO, "Serving builds on %s, Ctrl+C to stop", address.sun_path);
+
+	for (;;) {
+		struct pollfd fds[2] = {{w.fd, POLLIN, 0}, {server, POLLIN, 0}};
+		if (poll(fds, 2, -1) < 0) {
+			if (errno == EINTR) continue;
+			nob_return_defer(FAILED);
+		}
+		size_t temp_checkpoint = nob_temp_save();
+		if ((fds[0].revents & POLLIN) && watch__read(&w, &sources_dirty, &resources_dirty) == FAILED) nob_return_defer(FAILED);
+		nob_temp_rewind(temp_checkpoint);
+		if (!(fds[1].revents & POLLIN)) continue;
+
+		int client = accept(server, NULL, NULL);
+		if (client < 0) continue;
+		fcntl(client, F_SETFD, FD_CLOEXEC);
+		// Client that connects and never sends must not stall every other request
+		struct timeval timeout = {DAEMON_RECV_TIMEOUT_MS / 1000, (DAEMON_RECV_TIMEOUT_MS % 1000) * 1000};
+		setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+		struct {
+			uint32_t magic;
+			uint64_t key;
+		} request = {0};
+		char reply[2] = {'\0', DAEMON_MISMATCH};
+		struct FileStat now = {0};
+		if (recv(client, &request, sizeof(request), MSG_WAITALL) != sizeof(request) || request.magic != DAEMON_MAGIC) {
+			close(client);
+			continue;
+		}
+		if (!file_stat(executable_path, &now) || now.device != executable.device || now.inode != executable.inode || now.mtime_ns != executable.mtime_ns) {
+			reply[1] = DAEMON_STALE;
+		}
+		else if (request.key == snapshot_key) {
+			// Saves right before the request are already queued
+			while (poll(fds, 1, 0) > 0) {
+				if (watch__read(&w, &sources_dirty, &resources_dirty) == FAILED) break;
+			}
+			nob_temp_rewind(temp_checkpoint);
+			// Daemon started with -rebuild compiles those targets on every request
+			if (rebuild_forced) sources_dirty = true;
+			reply[1] = (char)daemon__build(client, &sources_dirty, &resources_dirty);
+		}
+		send(client, reply, sizeof(reply), MSG_NOSIGNAL);
+		close(client);
+		if (reply[1] == DAEMON_STALE) {
+			nob_log(NOB_INFO, "nob was rebuilt, stopping daemon");
+			break;
+		}
+	}
+
+defer:
+	if (server >= 0) {
+		close(server);
+		unlink(address.sun_path);
+	}
+	watch_close(&w);
+#else
+	// TODO: named pipes on Windows, kqueue for changes on macOS
+	nob_log(NOB_ERROR, "-daemon is only supported on Linux for now");
+	nob_return_defer(FAILED);
+defer:
+#endif
+	return result;
+}
+
+// Let a running daemon build, its log is printed as it arrives.
+// DAEMON_UNAVAILABLE, DAEMON_MISMATCH and DAEMON_STALE mean this process has to build itself.
+enum DAEMON_REPLY daemon_request() {
+	enum DAEMON_REPLY reply = DAEMON_UNAVAILABLE;
+#if defined(LINUX)
+	struct sockaddr_un address;
+	if (nob_file_exists(BUILD_FOLDER DAEMON_SOCKET_NAME) != 1) return DAEMON_UNAVAILABLE;
+	int client = daemon__socket(&address);
+	if (client < 0) return DAEMON_UNAVAILABLE;
+	if (connect(client, (struct sockaddr*)&address, sizeof(address)) != 0) {
+		close(client);
+		return DAEMON_UNAVAILABLE;
+	}
+	struct {
+		uint32_t magic;
+		uint64_t key;
+	} request = {DAEMON_MAGIC, snapshot_key};
+	if (send(client, &request, sizeof(request), MSG_NOSIGNAL) != sizeof(request)) {
+		close(client);
+		return DAEMON_UNAVAILABLE;
+	}
+
+	// Last two bytes are the reply, everything before is log
+	char buffer[4096 + 2];
+	size_t held = 0;
+	for (;;) {
+		ssize_t n = recv(client, buffer + held, sizeof(buffer) - held, 0);
+		if (n < 0 && errno == EINTR) continue;
+		if (n <= 0) break;
+		held += (size_t)n;
+		if (held > 2) {
+			fwrite(buffer, 1, held - 2, stderr);
+			memmove(buffer, buffer + held - 2, 2);
+			held = 2;
+		}
+	}
+	close(client);
+	if (held == 2 && buffer[0] == '\0') reply = (enum DAEMON_REPLY)buffer[1];
+#endif
+	return reply;
+}
+
+enum RESULT process_cli(int argc, char **argv) {
+	enum RESULT result = SUCCESS;
+	// Applied after other flags, every configuration gets the same -optimize, -wayland and so on
+	const char *configs = NULL;
 
 	// CLI
 	while (argc > 0) {
@@ -750,6 +1928,84 @@ enum RESULT process_cli(int argc, char **argv) {
 				current_config.platform = PLATFORM_WEB;
 			}
 		}
+		else if (strcmp(command_name, "-j") == 0) {
+			if (!(argc > 0)) {
+				nob_log(NOB_ERROR, "No job count provided after `-j`");
+				assert(false);
+				nob_return_defer(FAILED);
+			}
+			max_jobs = (size_t)atoi(nob_shift(argv, argc));
+		}
+		else if (strcmp(command_name, "-cache-size") == 0) {
+			if (!(argc > 0)) {
+				nob_log(NOB_ERROR, "No size in MiB provided after `-cache-size`");
+				assert(false);
+				nob_return_defer(FAILED);
+			}
+			cache_size_mib = (size_t)atoi(nob_shift(argv, argc));
+		}
+		else if (strcmp(command_name, "-no-cache") == 0) {
+			cache_size_mib = 0;
+		}
+		else if (strcmp(command_name, "-configs") == 0) {
+			if (!(argc > 0)) {
+				nob_log(NOB_ERROR, "No configurations provided after `-configs`");
+				assert(false);
+				nob_return_defer(FAILED);
+			}
+			configs = nob_shift(argv, argc);
+		}
+		else if (strcmp(command_name, "-only") == 0 || strcmp(command_name, "-rebuild") == 0) {
+			if (!(argc > 0)) {
+				nob_log(NOB_ERROR, "No targets provided after `%s`", command_name);
+				assert(false);
+				nob_return_defer(FAILED);
+			}
+			if (select_targets(nob_shift(argv, argc), strcmp(command_name, "-rebuild") == 0) == FAILED) nob_return_defer(FAILED);
+		}
+		else if (strcmp(command_name, "-watch") == 0) {
+			watch = true;
+		}
+		else if (strcmp(command_name, "-daemon") == 0) {
+			daemon_mode = true;
+		}
+		else if (strcmp(command_name, "-bench-copy") == 0) {
+			// Size is optional
+			bench_copy_mib = 256;
+			if (argc > 0 && isdigit((unsigned char)argv[0][0])) {
+				bench_copy_mib = (size_t)atoi(nob_shift(argv, argc));
+			}
+		}
+		else if (strcmp(command_name, "-bench-build") == 0) {
+			// Shape is optional, `modules,files,headers,fanout,plugins`
+			struct BenchShape shape = {8, 25, 32, 4, 2};
+			if (argc > 0 && isdigit((unsigned char)argv[0][0])) {
+				size_t *fields[] = {&shape.modules, &shape.files, &shape.headers, &shape.fanout, &shape.plugins};
+				Nob_String_View list = nob_sv_from_cstr(nob_shift(argv, argc));
+				for (size_t i = 0; i < NOB_ARRAY_LEN(fields) && list.count > 0; ++i) {
+					Nob_String_View field = nob_sv_chop_by_delim(&list, ',');
+					*fields[i] = (size_t)strtoull(nob_temp_sv_to_cstr(field), NULL, 10);
+				}
+			}
+			if (shape.modules == 0 || shape.files == 0 || shape.headers == 0) {
+				nob_log(NOB_ERROR, "`-bench-build` needs at least one module with one file and one header");
+				nob_return_defer(FAILED);
+			}
+			bench_shape = shape;
+		}
+		else if (strcmp(command_name, "-sync-hash") == 0) {
+			sync_hash = true;
+		}
+		else if (strcmp(command_name, "-no-pch") == 0) {
+			use_pch = false;
+		}
+		else if (strcmp(command_name, "-unity") == 0) {
+			// Chunk count is optional
+			build_unity.chunks = 1;
+			if (argc > 0 && isdigit((unsigned char)argv[0][0])) {
+				build_unity.chunks = (size_t)atoi(nob_shift(argv, argc));
+			}
+		}
 		else if (strcmp(command_name, "-optimize") == 0) {
 			if (!(argc > 0)) {
 				nob_log(NOB_ERROR, "No optimization option provided after `-optimize`");
@@ -773,15 +2029,71 @@ enum RESULT process_cli(int argc, char **argv) {
 				current_config.optimize = OPTIMIZATION_AGGRESSIVE;
 				// NOTE: MSVC needs to link "/LTCG"
 			}
+			else if (strcmp(optimize, "pgo") == 0) {
+				current_config.optimize = OPTIMIZATION_RELEASE;
+				use_pgo = true;
+			}
 		}
 	}
 
+	if (!targets_scoped) {
+		for (size_t i = 0; i < TARGET_COUNT; ++i) target_selected[i] = true;
+	}
+	if (use_pgo && !target_selected[TARGET_MAIN]) {
+		nob_log(NOB_ERROR, "`-optimize pgo` trains the main executable, `-only` has to include it");
+		nob_return_defer(FAILED);
+	}
+
+	build_configs[0] = current_config;
+	build_configs_count = 1;
+	if (configs != NULL) {
+		build_configs_count = 0;
+		Nob_String_View list = nob_sv_from_cstr(configs);
+		while (list.count > 0) {
+			Nob_String_View name = nob_sv_chop_by_delim(&list, ',');
+			struct SavedConfig config = current_config;
+			if (config.platform == PLATFORM_WEB) config.platform = PLATFORM_DESKTOP;
+			if (nob_sv_eq(name, nob_sv_from_cstr("debug"))) {
+				config.is_debug = true;
+			}
+			else if (nob_sv_eq(name, nob_sv_from_cstr("release"))) {
+				config.is_debug = false;
+			}
+			else if (nob_sv_eq(name, nob_sv_from_cstr("web"))) {
+				config.is_debug = false;
+				config.platform = PLATFORM_WEB;
+			}
+			else {
+				nob_log(NOB_ERROR, "Unknown configuration `"SV_Fmt"`, expected debug, release or web", SV_Arg(name));
+				nob_return_defer(FAILED);
+			}
+			// Same configuration twice would build into the same directories
+			bool duplicate = false;
+			for (size_t i = 0; i < build_configs_count; ++i) {
+				duplicate = duplicate || (build_configs[i].is_debug == config.is_debug && build_configs[i].platform == config.platform);
+			}
+			if (duplicate) continue;
+			if (build_configs_count == NOB_ARRAY_LEN(build_configs)) break;
+			build_configs[build_configs_count++] = config;
+		}
+		if (build_configs_count == 0) {
+			nob_log(NOB_ERROR, "No configurations provided after `-configs`");
+			nob_return_defer(FAILED);
+		}
+		if (use_pgo && build_configs_count > 1) {
+			nob_log(NOB_ERROR, "`-optimize pgo` trains one configuration at a time, it can't be used with several `-configs`");
+			nob_return_defer(FAILED);
+		}
+	}
+	use_config(0);
+
 defer:
 	return result;
 }
 
 int main(int argc, char **argv) {
-	NOB_GO_REBUILD_URSELF(argc, argv);
+	NOB_GO_REBUILD_URSELF_PLUS(argc, argv, "include/nob_utils.h", "include/nob_graph.h", "include/nob_build.h", "include/nob_trace.h", "include/nob_archive.h");
+	trace_start();
 	enum RESULT result = SUCCESS;
 	size_t temp_checkpoint = nob_temp_save();
 	char root_dir[1024] = {0};
@@ -800,6 +2112,44 @@ int main(int argc, char **argv) {
 		assert(false);
 		nob_return_defer(FAILED);
 	}
+	set_snapshot_key(argc, argv);
+
+	if (bench_copy_mib > 0) {
+		result = bench_copy_file(bench_copy_mib);
+		trace_free();
+		nob_return_defer(result);
+	}
+	if (bench_shape.modules > 0) {
+		result = bench_build();
+		trace_free();
+		nob_return_defer(result);
+	}
+
+	// Running daemon already knows what changed
+	if (!watch && !daemon_mode && !rebuild_forced) {
+		enum DAEMON_REPLY reply = daemon_request();
+		if (reply == DAEMON_OK || reply == DAEMON_FAILED) {
+			trace_free();
+			nob_return_defer(reply == DAEMON_OK ? SUCCESS : FAILED);
+		}
+		if (reply == DAEMON_STALE) nob_log(NOB_INFO, "Daemon runs an older nob, building locally");
+		if (reply == DAEMON_MISMATCH) nob_log(NOB_INFO, "Daemon serves other arguments, building locally");
+	}
+
+	// Nothing the last identical build depended on changed, skip downloads, planning and graph
+	size_t snapshot_checked = 0;
+	if (!watch && !daemon_mode && !rebuild_forced && build_snapshot_unchanged(BUILD_FOLDER SNAPSHOT_FILE_NAME, snapshot_key, &snapshot_checked)) {
+		nob_log(NOB_INFO, "Nothing changed, no-op build took %.2f ms (%zu files checked)",
+			(nob_nanos_since_unspecified_epoch() - build_trace.start_ns) / 1e6, snapshot_checked);
+		trace_free();
+		nob_return_defer(SUCCESS);
+	}
+
+	if (jobserver_init(max_jobs) == FAILED) {
+		nob_log(NOB_ERROR, "Failed to set up jobserver");
+		assert(false);
+		nob_return_defer(FAILED);
+	}
 
 	if (!nob_mkdir_if_not_exists(DOWNLOAD_FOLDER)) nob_return_defer(FAILED);
 	if (!nob_mkdir_if_not_exists(DEPENDENCY_FOLDER)) nob_return_defer(FAILED);
@@ -809,13 +2159,13 @@ int main(int argc, char **argv) {
 	if (!nob_mkdir_if_not_exists(WEB_FOLDER)) nob_return_defer(FAILED);
 	if (!nob_mkdir_if_not_exists(OBJ_FOLDER)) nob_return_defer(FAILED);
 	if (!nob_mkdir_if_not_exists(LIB_FOLDER)) nob_return_defer(FAILED);
+	if (setup_build_cache() == FAILED) nob_return_defer(FAILED);
 
-	struct SavedConfig saved_config = {0};
-	if (load_binary(&saved_config, sizeof(saved_config), BUILD_FOLDER CONFIG_FILE_NAME, config_version) == 0) {
-		previous_config = &saved_config;
-	}
-	
-	if (current_config.platform == PLATFORM_WEB) {
+	// Downloads and toolchains are shared by all configurations
+	bool any_web = false;
+	for (size_t i = 0; i < build_configs_count; ++i) any_web = any_web || build_configs[i].platform == PLATFORM_WEB;
+	if (any_web) {
+		size_t phase = trace_phase_begin("setup emscripten");
 		if (download_emscripten()) {
 			nob_log(NOB_ERROR, "Failed to download Emscripten");
 			assert(false);
@@ -828,34 +2178,65 @@ int main(int argc, char **argv) {
 			assert(false);
 			nob_return_defer(FAILED);
 		}
+		trace_phase_end(phase);
 	}
 
-	if (download_raylib()) {
+	// Only the executable and raylib itself need raylib sources
+	if ((target_selected[TARGET_RAYLIB] || target_selected[TARGET_MAIN]) && download_raylib()) {
 		nob_log(NOB_ERROR, "Failed to download Raylib");
 		assert(false);
 		nob_return_defer(FAILED);
 	}
 	
-	if (setup_resources() == FAILED) {
+	size_t resources_phase = trace_phase_begin("setup resources");
+	enum RESULT resources_result = setup_resources();
+	trace_phase_end(resources_phase);
+	if (resources_result == FAILED) {
 		nob_log(NOB_ERROR, "Failed to setup web directory");
 		assert(false);
 		nob_return_defer(FAILED);
 	}
 
 	// Compile project
-	if (compile_project()) {
-		nob_log(NOB_ERROR, "Failed to get source files");
-		assert(false);
-		nob_return_defer(FAILED);
+	if (use_pgo) {
+		if (compile_pgo() == FAILED) {
+			nob_log(NOB_ERROR, "Failed profile guided build");
+			build_snapshot_free();
+			assert(false);
+			nob_return_defer(FAILED);
+		}
+		save_snapshot(SUCCESS);
+	}
+	else {
+		enum RESULT build_result = compile_project();
+		save_snapshot(build_result);
+		if (build_result == FAILED && !watch && !daemon_mode) {
+			nob_log(NOB_ERROR, "Failed to get source files");
+			assert(false);
+			nob_return_defer(FAILED);
+		}
 	}
 
-	if (save_binary(&current_config, sizeof(current_config), BUILD_FOLDER CONFIG_FILE_NAME, config_version) == FAILED) {
-		nob_log(NOB_ERROR, "Failed to save config");
-		assert(false);
-		nob_return_defer(FAILED);
+	if (watch) {
+		finish_trace();
+		if (watch_project() == FAILED) {
+			nob_log(NOB_ERROR, "Failed to watch project");
+			assert(false);
+			nob_return_defer(FAILED);
+		}
+	}
+	else if (daemon_mode) {
+		finish_trace();
+		if (serve_daemon() == FAILED) {
+			nob_log(NOB_ERROR, "Failed to serve builds");
+			assert(false);
+			nob_return_defer(FAILED);
+		}
 	}
 
 defer:
+	// Timeline of whatever ran, failed builds included
+	finish_trace();
 	nob_set_current_dir(starting_cwd);
 	return result;
 }
@@ -3,6 +3,7 @@
 #include "load_library.h"
 #include "os/executable_directory.h"
 #include "plug_host.h"
+#include <stdlib.h>
 
 void test_dll();
 void test_plug();
@@ -15,15 +16,25 @@ int main(void) {
     const int screenWidth = 800;
     const int screenHeight = 450;
 
+    // Set by `nob -optimize pgo` for the profile training run
+    int training_frames = 0;
+    const char *training = getenv("TRAINING_FRAMES");
+    if (training != NULL) {
+        training_frames = atoi(training);
+        SetConfigFlags(FLAG_WINDOW_HIDDEN);
+    }
+
     InitWindow(screenWidth, screenHeight, "raylib template");
 
-    SetTargetFPS(60);
+    SetTargetFPS(training_frames > 0 ? 0 : 60);
 
     test_dll();
     test_plug();
 
     while (!WindowShouldClose())
     {
+        if (training_frames > 0 && --training_frames == 0) break;
+
         // Update
         adjust_update();
 